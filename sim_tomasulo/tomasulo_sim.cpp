@@ -7,12 +7,57 @@
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <iterator>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <random>
+#include <numeric>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <bitset>
+#include <array>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
 
 struct InstrucaoInput { // armazena a instrução lida no arquivo de entrada
     std::string d_operacao;
     std::string r_reg;
     std::string s_reg_or_imm;
     std::string t_reg_or_label;
+    std::string rotulo;        // "Rotulo:" no início da linha (ou na linha anterior)
+    std::string padrao_desvio; // desvios: "@TTN" dá os resultados sucessivos (T = tomado, N = não tomado)
+};
+
+struct PalavraInicial { // uma palavra de 8 bytes do bloco de dados
+    uint64_t endereco;
+    uint64_t valor;        // bits: double se pontoFlutuante, senão inteiro
+    bool pontoFlutuante;
+};
+
+struct DadosIniciais { // bloco DATA_BEGIN/DATA_END: valores iniciais da execução funcional
+    std::map<std::string, uint64_t> registradores; // nome -> bits do valor (double nos F, inteiro nos demais)
+    std::vector<PalavraInicial> memoria;
+};
+
+struct ConfigPipeline { // PIPES <Classe> <Quantidade> [II <Intervalo>]
+    int quantidade = 1;
+    int intervalo = 1; // ciclos entre duas instruções aceitas pela mesma unidade
 };
 
 struct ConfigSimulador {
@@ -20,668 +65,6174 @@ struct ConfigSimulador {
     std::map<std::string, int> ciclos;
     std::map<std::string, int> unidades;
     std::map<std::string, int> unidadesMem;
+    std::map<std::string, ConfigPipeline> pipelines; // classes com unidades de execução separadas das estações
+    int larguraEmissao = 1; // ISSUE_WIDTH: instruções emitidas em ordem por ciclo
+    int numCDBs = 0;        // CDB_COUNT: escritas por ciclo; 0 = sem limite
+    int tamanhoROB = 0;     // ROB_SIZE: 0 = sem ROB (sem efetivação em ordem nem especulação)
+    int larguraCommit = 0;  // COMMIT_WIDTH: efetivações por ciclo; 0 = igual a ISSUE_WIDTH
+    int preditor = 0;       // PREDICTOR: índice em NOMES_PREDITORES (só com ROB)
+    int bitsPreditor = 10;  // PREDICTOR_BITS: log2 das entradas da tabela principal do preditor
+    int bitsHistorico = 8;  // HISTORY_BITS: histórico global do gshare; o mais longo do TAGE
+    int funcional = 0;      // FUNCTIONAL: 1 = calcula os valores, endereços e desvios de verdade
+    int modoLSQ = 0;        // LSQ: índice em NOMES_MODOS_LSQ
+    int tamanhoL1 = 0;      // L1D_SIZE: bytes da cache de dados; 0 = latência fixa de CYCLES Load/Store
+    int viasL1 = 4;         // L1D_ASSOC
+    int tamanhoL2 = 0;      // L2_SIZE: bytes; 0 = as faltas da L1 vão direto à DRAM
+    int viasL2 = 8;         // L2_ASSOC
+    int latenciaL2 = 10;    // L2_LATENCY: ciclos somados a um acesso que falta na L1
+    int latenciaDRAM = 100; // DRAM_LATENCY: ciclos somados a um acesso que falta na última cache
+    int tamanhoLinha = 64;  // CACHE_LINE: bytes por linha nas duas caches
+    int politicaCache = 0;  // CACHE_POLICY: índice em NOMES_POLITICAS_CACHE
+    int numMSHRs = 8;       // MSHR_COUNT: faltas da L1 em andamento ao mesmo tempo
+    DadosIniciais dados;
+};
+
+enum class TipoPreditor : uint8_t { Estatico, Bimodal, Gshare, Tage };
+const char* const NOMES_PREDITORES[] = {"estatico", "bimodal", "gshare", "tage", nullptr};
+
+// nenhum: loads ignoram as stores (modelo original); conservador: o load espera os endereços de todas as stores
+// mais antigas; perfeito: espera só as stores do mesmo endereço (oráculo); especulativo: passa pelas stores de
+// endereço desconhecido e é reexecutado se uma delas se revelar do mesmo endereço
+enum class ModoLSQ : uint8_t { Nenhum, Conservador, Perfeito, Especulativo };
+const char* const NOMES_MODOS_LSQ[] = {"nenhum", "conservador", "perfeito", "especulativo", nullptr};
+
+enum class PoliticaCache : uint8_t { Lru, Plru };
+const char* const NOMES_POLITICAS_CACHE[] = {"lru", "plru", nullptr};
+
+struct ParametroEscalar { // palavra-chave do bloco de configuração com um único valor inteiro
+    const char* chave;
+    int ConfigSimulador::*campo;
+    int minimo;
+    int maximo;
+    int padrao;
+    const char* const* nomes; // valores simbólicos (índice = valor), terminados em nullptr; nullptr se numérico
+};
+
+const ParametroEscalar PARAMETROS_ESCALARES[] = {
+    {"ISSUE_WIDTH",    &ConfigSimulador::larguraEmissao, 1, INT32_MAX, 1,  nullptr},
+    {"CDB_COUNT",      &ConfigSimulador::numCDBs,        0, INT32_MAX, 0,  nullptr},
+    {"ROB_SIZE",       &ConfigSimulador::tamanhoROB,     0, INT32_MAX, 0,  nullptr},
+    {"COMMIT_WIDTH",   &ConfigSimulador::larguraCommit,  0, INT32_MAX, 0,  nullptr},
+    {"PREDICTOR",      &ConfigSimulador::preditor,       0, 3,         0,  NOMES_PREDITORES},
+    {"PREDICTOR_BITS", &ConfigSimulador::bitsPreditor,   2, 24,        10, nullptr},
+    {"HISTORY_BITS",   &ConfigSimulador::bitsHistorico,  0, 64,        8,  nullptr},
+    {"FUNCTIONAL",     &ConfigSimulador::funcional,      0, 1,         0,  nullptr},
+    {"LSQ",            &ConfigSimulador::modoLSQ,        0, 3,         0,  NOMES_MODOS_LSQ},
+    {"L1D_SIZE",       &ConfigSimulador::tamanhoL1,      0, 1 << 30,   0,  nullptr},
+    {"L1D_ASSOC",      &ConfigSimulador::viasL1,         1, 64,        4,  nullptr},
+    {"L2_SIZE",        &ConfigSimulador::tamanhoL2,      0, 1 << 30,   0,  nullptr},
+    {"L2_ASSOC",       &ConfigSimulador::viasL2,         1, 64,        8,  nullptr},
+    {"L2_LATENCY",     &ConfigSimulador::latenciaL2,     0, 100000,    10, nullptr},
+    {"DRAM_LATENCY",   &ConfigSimulador::latenciaDRAM,   0, 100000,    100, nullptr},
+    {"CACHE_LINE",     &ConfigSimulador::tamanhoLinha,   8, 4096,      64, nullptr},
+    {"CACHE_POLICY",   &ConfigSimulador::politicaCache,  0, 1,         0,  NOMES_POLITICAS_CACHE},
+    {"MSHR_COUNT",     &ConfigSimulador::numMSHRs,       1, 1024,      8,  nullptr},
+};
+constexpr int NUM_PARAMETROS_ESCALARES = sizeof(PARAMETROS_ESCALARES) / sizeof(PARAMETROS_ESCALARES[0]);
+
+const ParametroEscalar* buscaParametroEscalar(const std::string& chave) {
+    for (const auto& p : PARAMETROS_ESCALARES) {
+        if (chave == p.chave) return &p;
+    }
+    return nullptr;
+}
+
+void defineParametro(ConfigSimulador& config, const ParametroEscalar& p, int valor) {
+    config.*p.campo = std::min(p.maximo, std::max(p.minimo, valor));
+}
+
+bool leValorParametro(const ParametroEscalar& p, const std::string& texto, int& valor) { // um número ou, se o parâmetro tem nomes, um deles
+    for (int i = 0; p.nomes && p.nomes[i]; ++i) {
+        if (texto == p.nomes[i]) {
+            valor = i;
+            return true;
+        }
+    }
+    char* fim = nullptr;
+    long v = std::strtol(texto.c_str(), &fim, 10);
+    if (texto.empty() || *fim != '\0') return false;
+    valor = static_cast<int>(v);
+    return true;
+}
+
+std::string textoParametro(const ParametroEscalar& p, int valor) {
+    return p.nomes && valor >= p.minimo && valor <= p.maximo ? p.nomes[valor] : std::to_string(valor);
+}
+
+// valores da execução funcional: 64 bits brutos, interpretados como double nos registradores F e como inteiro nos demais
+
+uint64_t bitsDouble(double v) {
+    uint64_t b;
+    std::memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+double doubleDosBits(uint64_t b) {
+    double v;
+    std::memcpy(&v, &b, sizeof(v));
+    return v;
+}
+
+uint64_t inteiroDoDouble(double v) { // truncado; NaN e valores fora da faixa viram 0
+    return std::isfinite(v) && std::fabs(v) < 9.2e18 ? static_cast<uint64_t>(static_cast<int64_t>(v)) : 0;
+}
+
+bool ehRegistradorPF(const std::string& nome) { return !nome.empty() && nome[0] == 'F'; }
+
+bool literalPontoFlutuante(const std::string& texto) { return texto.find_first_of(".eEiInN") != std::string::npos; }
+
+uint64_t valorLiteral(const std::string& texto, bool pontoFlutuante) { // bits do literal convertido para o tipo pedido
+    if (pontoFlutuante) return bitsDouble(std::strtod(texto.c_str(), nullptr));
+    if (literalPontoFlutuante(texto)) return inteiroDoDouble(std::strtod(texto.c_str(), nullptr));
+    return static_cast<uint64_t>(std::strtoll(texto.c_str(), nullptr, 10));
+}
+
+std::string textoValor(uint64_t bits, bool pontoFlutuante) {
+    if (!pontoFlutuante) return std::to_string(static_cast<int64_t>(bits));
+    std::ostringstream out;
+    out << std::setprecision(15) << doubleDosBits(bits);
+    return out.str();
+}
+
+constexpr uint32_t SEM_TAG = 0xFFFFFFFF;  // tag vazia: nenhuma estação produtora
+constexpr uint32_t SEM_ID = 0xFFFFFFFF;   // id de nome ausente
+constexpr int32_t SEM_TEMPO = INT32_MIN;  // tempo de estação livre (impresso como "-")
+constexpr int64_t FIM_PROGRAMA = INT64_MAX; // alvo de desvio além da última instrução
+
+// checkpoint: cada classe percorre os seus campos em serializa(ArquivoEstado&), e o mesmo percurso grava ou lê,
+// conforme o arquivo; vetores levam o tamanho à frente e os de tipos simples vão num único bloco
+class ArquivoEstado {
+public:
+    explicit ArquivoEstado(std::ostream& out) : out(&out) {}
+    ArquivoEstado(std::istream& in, uint64_t tamanho) : in(&in), restante(tamanho) {}
+
+    bool lendo() const { return in != nullptr; }
+    bool ok() const { return !falhou && (out ? out->good() : !in->fail()); }
+    void falha() { falhou = true; }
+
+    template <typename T>
+    void campo(T& v) {
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) bloco(&v, sizeof(T));
+        else v.serializa(*this);
+    }
+
+    template <typename T, size_t N>
+    void campo(T (&v)[N]) {
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) bloco(v, sizeof(v));
+        else for (T& e : v) campo(e);
+    }
+
+    template <typename T>
+    void campo(std::optional<T>& v) {
+        uint8_t presente = v.has_value();
+        campo(presente);
+        if (lendo()) v = presente ? std::optional<T>(T()) : std::nullopt;
+        if (presente) campo(*v);
+    }
+
+    template <typename T>
+    void campo(std::vector<T>& v) {
+        uint64_t n = v.size();
+        campo(n);
+        if (lendo()) {
+            if (falhou || n > restante) return falha(); // cada elemento ocupa ao menos um byte
+            v.resize(n);
+        }
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) bloco(v.data(), n * sizeof(T));
+        else for (T& e : v) campo(e);
+    }
+
+    template <typename T>
+    void campoFixo(std::vector<T>& v) { // vetor com o tamanho dado pela configuração: um tamanho diferente no arquivo é erro
+        uint64_t n = v.size();
+        campo(n);
+        if (lendo() && n != v.size()) return falha();
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) bloco(v.data(), n * sizeof(T));
+        else for (T& e : v) campo(e);
+    }
+
+    template <typename K, typename V>
+    void campo(std::unordered_map<K, V>& m) { // em ordem de chave: o mesmo estado dá sempre o mesmo arquivo
+        std::vector<K> chaves;
+        for (const auto& e : m) chaves.push_back(e.first);
+        std::sort(chaves.begin(), chaves.end());
+        campo(chaves);
+        if (lendo()) m.clear();
+        for (const K& k : chaves) campo(m[k]);
+    }
+
+private:
+    std::ostream* out = nullptr;
+    std::istream* in = nullptr;
+    uint64_t restante = 0; // bytes ainda não lidos do arquivo
+    bool falhou = false;
+
+    void bloco(void* p, size_t n) {
+        if (out) {
+            out->write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+            return;
+        }
+        if (falhou || n > restante) return falha();
+        in->read(static_cast<char*>(p), static_cast<std::streamsize>(n));
+        restante -= n;
+        if (!*in) falha();
+    }
+};
+
+class TabelaNomes { // interna nomes de registradores e literais como ids inteiros
+public:
+    uint32_t interna(const std::string& s) {
+        auto it = indice.find(s);
+        if (it != indice.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(nomes.size());
+        nomes.push_back(s);
+        indice.emplace(s, id);
+        return id;
+    }
+    const std::string& nome(uint32_t id) const { return nomes[id]; }
+    size_t size() const { return nomes.size(); }
+
+private:
+    std::vector<std::string> nomes;
+    std::unordered_map<std::string, uint32_t> indice;
+};
+
+enum class Opcode : uint8_t { ADDD, SUBD, MULTD, DIVD, LD, SD, ADD, DADDUI, BEQ, BNEZ, Desconhecido };
+
+enum class ClasseUF : uint8_t { Add, Mult, Div, Integer, Load, Store, Nenhuma };
+constexpr int NUM_CLASSES_UF = static_cast<int>(ClasseUF::Nenhuma);
+const char* const NOMES_CLASSES_UF[NUM_CLASSES_UF] = {"Add", "Mult", "Div", "Integer", "Load", "Store"};
+
+// flags do opcode
+constexpr uint8_t ESCREVE_REGISTRADOR = 1; // R é o destino
+constexpr uint8_t DESVIO = 2;              // fontes em R e S; T é o rótulo
+constexpr uint8_t ACESSO_MEMORIA = 4;      // usa os buffers de Load/Store; S é o deslocamento e T a base
+constexpr uint8_t ARMAZENA = 8;            // R é o dado a ser escrito na memória
+constexpr uint8_t CONTA_NA_EMISSAO = 16;   // o primeiro ciclo de execução coincide com a emissão
+
+struct InfoOpcode { // uma linha da tabela de decodificação
+    const char* nome;
+    Opcode op;
+    ClasseUF classe;
+    uint8_t flags;
+};
+
+// para suportar um opcode novo basta acrescentá-lo aqui (e ao enum Opcode)
+const InfoOpcode TABELA_OPCODES[] = {
+    {"ADDD",   Opcode::ADDD,   ClasseUF::Add,     ESCREVE_REGISTRADOR | CONTA_NA_EMISSAO},
+    {"SUBD",   Opcode::SUBD,   ClasseUF::Add,     ESCREVE_REGISTRADOR | CONTA_NA_EMISSAO},
+    {"MULTD",  Opcode::MULTD,  ClasseUF::Mult,    ESCREVE_REGISTRADOR},
+    {"DIVD",   Opcode::DIVD,   ClasseUF::Div,     ESCREVE_REGISTRADOR},
+    {"LD",     Opcode::LD,     ClasseUF::Load,    ESCREVE_REGISTRADOR | ACESSO_MEMORIA},
+    {"SD",     Opcode::SD,     ClasseUF::Store,   ACESSO_MEMORIA | ARMAZENA},
+    {"ADD",    Opcode::ADD,    ClasseUF::Integer, ESCREVE_REGISTRADOR},
+    {"DADDUI", Opcode::DADDUI, ClasseUF::Integer, ESCREVE_REGISTRADOR},
+    {"BEQ",    Opcode::BEQ,    ClasseUF::Integer, DESVIO},
+    {"BNEZ",   Opcode::BNEZ,   ClasseUF::Integer, DESVIO},
+};
+
+const InfoOpcode* buscaOpcode(const std::string& nome) {
+    for (const auto& info : TABELA_OPCODES) {
+        if (nome == info.nome) return &info;
+    }
+    return nullptr;
+}
+
+ClasseUF classePorNome(const std::string& nome) {
+    for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+        if (nome == NOMES_CLASSES_UF[c]) return static_cast<ClasseUF>(c);
+    }
+    return ClasseUF::Nenhuma;
+}
+
+struct OperandoDecodificado { // operando fonte resolvido na decodificação
+    uint32_t nome = SEM_ID;    // SEM_ID => operando ausente ("N/A")
+    int32_t registrador = -1;  // -1 => literal
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(nome);
+        a.campo(registrador);
+    }
+};
+
+struct InstrucaoDecodificada { // registro compacto gerado uma única vez pelo decodificador
+    Opcode op = Opcode::Desconhecido;
+    ClasseUF classe = ClasseUF::Nenhuma;
+    uint8_t flags = 0;
+    int32_t destino = -1;        // registrador escrito, -1 se nenhum
+    OperandoDecodificado fonteJ; // aritméticas: Vj/Qj; memória: dado do SD (Qi)
+    OperandoDecodificado fonteK; // aritméticas: Vk/Qk; memória: base (Qj)
+    int64_t imediato = 0;        // deslocamento do LD/SD ou imediato do DADDUI
+    uint32_t texto[4] = {SEM_ID, SEM_ID, SEM_ID, SEM_ID}; // op, R, S e T como escritos no arquivo
+    uint32_t rotulo = SEM_ID;    // desvios: id do nome do rótulo de destino (último operando)
+    uint32_t padrao = SEM_ID;    // desvios: id do texto do padrão de resultados, SEM_ID = nunca tomado
+
+    bool memoria() const { return flags & ACESSO_MEMORIA; }
+
+    bool consistente(size_t numNomes, size_t numRegistradores) const { // lida de um checkpoint: opcode como na tabela e ids dentro das tabelas
+        bool conhecido = op == Opcode::Desconhecido && classe == ClasseUF::Nenhuma && flags == 0; // como o decodificador a deixa
+        for (const auto& info : TABELA_OPCODES) conhecido = conhecido || (op == info.op && classe == info.classe && flags == info.flags);
+        if (!conhecido) return false;
+        for (int32_t r : {destino, fonteJ.registrador, fonteK.registrador}) {
+            if (r < -1 || (r >= 0 && static_cast<size_t>(r) >= numRegistradores)) return false;
+        }
+        for (uint32_t id : {fonteJ.nome, fonteK.nome, texto[0], texto[1], texto[2], texto[3], rotulo, padrao}) {
+            if (id != SEM_ID && id >= numNomes) return false;
+        }
+        return true;
+    }
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(op);
+        a.campo(classe);
+        a.campo(flags);
+        a.campo(destino);
+        a.campo(fonteJ);
+        a.campo(fonteK);
+        a.campo(imediato);
+        a.campo(texto);
+        a.campo(rotulo);
+        a.campo(padrao);
+    }
 };
 
-struct InstrucaoDetalhes { //campos da instrução
-    std::string operacao;
-    std::string registradorR;
-    std::string registradorS;
-    std::string registradorT;
+struct ProgramaDecodificado { // instruções decodificadas e tabela de registradores, compartilhadas somente para leitura
+    TabelaNomes nomes;
+    std::vector<InstrucaoDecodificada> instrucoes;
+    std::vector<uint32_t> nomeRegistrador;  // id de registrador -> id de nome
+    std::vector<uint8_t> registradorInicial; // registradores impressos desde o ciclo 0 (F pares e R)
+    std::vector<uint32_t> ordemRegistradores; // ids em ordem alfabética de nome (ordem de impressão)
+    uint32_t idNaoAplicavel = SEM_ID;
+    std::unordered_map<uint32_t, int64_t> rotulos; // id do nome do rótulo -> índice da instrução rotulada
+    int64_t periodo = 0; // > 0: as instruções se repetem a cada periodo posições (FonteSintetica)
+
+    int64_t alvo(const InstrucaoDecodificada& d, int64_t pc) const { // rótulo indefinido (ou no fim do arquivo): FIM_PROGRAMA
+        if (periodo > 0) return (pc / periodo + 1) * periodo; // o início do bloco, na repetição seguinte: a posição só avança
+        auto it = rotulos.find(d.rotulo);
+        return it != rotulos.end() ? it->second : FIM_PROGRAMA;
+    }
+
+    const std::string& texto(uint32_t id) const { return id == SEM_ID ? vazio : nomes.nome(id); }
+
+private:
+    std::string vazio;
 };
 
+enum class TipoOperando : uint8_t { Vazio, Literal, Valor }; // Literal: id de nome; Valor: tag da produtora, impressa como VAL(nome)
+enum class EstadoRegistrador : uint8_t { Livre, Pendente, Valor };
+
 struct EstadoInstrucao { //guarda o estado de uma determinada instrução durante a execução do algoritmo
-    InstrucaoDetalhes instrucao;
-    int posicao;
-    std::optional<int> issue;
-    std::optional<int> exeCompleta;
-    std::optional<int> write;
+    InstrucaoDecodificada instrucao;
+    int64_t posicao;
+    std::optional<int64_t> issue;
+    std::optional<int64_t> exeCompleta;
+    std::optional<int64_t> write;
+    std::optional<int64_t> commit;
+    int64_t pc = 0;              // índice da instrução no programa (posicao conta as instâncias buscadas)
+    bool tomado = false;         // desvios: resultado real, pelo padrão "@"
+    bool previstoTomado = false; // desvios: previsão usada na busca
+    uint64_t historico = 0;      // desvios: histórico global antes da previsão
+    uint64_t endereco = 0;       // LD/SD: endereço efetivo (FUNCTIONAL 1) ou, no LSQ sem ele, o deslocamento
+    uint64_t baseEndereco = 0;   // LSQ sem endereço real: registrador base e sua geração na emissão
+    bool enderecoReal = false;   // endereco calculado pela execução funcional
+    bool iniciouMemoria = false; // LSQ: load já liberado para ler a memória (ou receber o dado de uma store)
+    int64_t posicaoFonte = -1;   // LSQ: posição da store que encaminhou o dado ao load, -1 se leu a memória
+    bool acessouCache = false;   // LD/SD: latência da hierarquia de memória já somada ao tempo da estação
     bool busy = false;
+    bool ativa = false; // false: vaga livre da janela
+
+    EstadoInstrucao() : posicao(0), busy(false) {}
+    EstadoInstrucao(const InstrucaoDecodificada& instr, int64_t pos)
+        : instrucao(instr), posicao(pos), busy(false), ativa(true) {}
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(instrucao);
+        a.campo(posicao);
+        a.campo(issue);
+        a.campo(exeCompleta);
+        a.campo(write);
+        a.campo(commit);
+        a.campo(pc);
+        a.campo(tomado);
+        a.campo(previstoTomado);
+        a.campo(historico);
+        a.campo(endereco);
+        a.campo(baseEndereco);
+        a.campo(enderecoReal);
+        a.campo(iniciouMemoria);
+        a.campo(posicaoFonte);
+        a.campo(acessouCache);
+        a.campo(busy);
+        a.campo(ativa);
+    }
+};
+
+struct ResultadoInstrucao { // registro compacto dos ciclos de uma instrução (-1: ainda não ocorreu)
+    int64_t posicao;
+    int64_t issue;
+    int64_t exeCompleta;
+    int64_t write;
+    int64_t commit;    // -1 também sem ROB
+    uint32_t texto[4]; // como em InstrucaoDecodificada
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(posicao);
+        a.campo(issue);
+        a.campo(exeCompleta);
+        a.campo(write);
+        a.campo(commit);
+        a.campo(texto);
+    }
+};
+
+class DestinoResultados { // recebe as instruções à medida que escrevem (fora de ordem de programa)
+public:
+    virtual ~DestinoResultados() = default;
+    virtual void registra(const ResultadoInstrucao& r) = 0;
+};
+
+class GravadorResultados : public DestinoResultados { // grava "posicao issue exec write" por linha, sem guardar nada em memória
+public:
+    explicit GravadorResultados(std::ostream& out) : out(out) {}
+    void registra(const ResultadoInstrucao& r) override {
+        out << r.posicao << ' ' << r.issue << ' ' << r.exeCompleta << ' ' << r.write;
+        if (r.commit >= 0) out << ' ' << r.commit;
+        out << '\n';
+    }
+
+private:
+    std::ostream& out;
+};
+
+class ColetorResultados : public DestinoResultados { // guarda os registros para o relatório final
+public:
+    std::vector<ResultadoInstrucao> resultados;
+    void registra(const ResultadoInstrucao& r) override { resultados.push_back(r); }
+};
+
+class FonteInstrucoes { // entrega as instruções decodificadas em ordem de programa
+public:
+    virtual ~FonteInstrucoes() = default;
+    virtual bool proxima(InstrucaoDecodificada& out) = 0;
+    virtual bool vazia() = 0; // true se proxima não tem mais nada a entregar; não consome instruções
+    virtual bool posiciona(int64_t) { return false; } // desvios: continua a partir do índice dado; false se a fonte não volta atrás
+};
+
+class FontePrograma : public FonteInstrucoes { // percorre um programa já decodificado em memória
+public:
+    explicit FontePrograma(std::shared_ptr<const ProgramaDecodificado> programa) : programa(std::move(programa)) {}
+    bool proxima(InstrucaoDecodificada& out) override {
+        if (i >= programa->instrucoes.size()) return false;
+        out = programa->instrucoes[i++];
+        return true;
+    }
+    bool vazia() override { return i >= programa->instrucoes.size(); }
+    bool posiciona(int64_t indice) override {
+        i = static_cast<size_t>(std::min<int64_t>(indice, programa->instrucoes.size()));
+        return true;
+    }
+
+private:
+    std::shared_ptr<const ProgramaDecodificado> programa;
+    size_t i = 0;
+};
+
+enum class MotivoEmissao : uint8_t { Emitiu, SemInstrucao, EstacaoOcupada, OpcodeDesconhecido, RobCheio };
+constexpr int NUM_MOTIVOS_EMISSAO = 5;
+
+struct EstatisticaDesvio { // por desvio do programa (pc), contada na efetivação
+    uint32_t op = SEM_ID;
+    uint32_t rotulo = SEM_ID;
+    int64_t execucoes = 0;
+    int64_t erros = 0;
+    int64_t ciclosPenalidade = 0; // da emissão à resolução (escrita) dos desvios mal previstos
+};
+
+constexpr int NUM_FAIXAS_LATENCIA = 20;
+
+struct Contadores { // contadores de desempenho (--estatisticas); somas por ciclo, incluindo os ciclos pulados
+    int64_t ciclos = 0;
+    int64_t emitidas = 0;
+    int64_t ciclosPorMotivo[NUM_MOTIVOS_EMISSAO] = {};
+    int64_t bloqueiosPorClasse[NUM_CLASSES_UF] = {}; // ciclos sem emissão por falta de estação livre da classe
+    int64_t ocupacaoPorClasse[NUM_CLASSES_UF] = {};  // estações ocupadas
+    int estacoesPorClasse[NUM_CLASSES_UF] = {};
+    int64_t esperaOperandos = 0;                     // estações com Qj/Qk pendente (RAW)
+    int64_t escritas = 0;
+    int64_t ciclosComEscrita = 0;
+    int64_t maximoEscritasCiclo = 0;
+    int64_t ciclosDisputaCDB = 0;                    // ciclos com mais resultados prontos que CDBs
+    int64_t esperaCDB = 0;                           // resultados prontos que ficaram para o ciclo seguinte
+    int64_t desvios = 0;                             // desvios efetivados
+    int64_t errosPrevisao = 0;
+    int64_t ciclosPenalidade = 0;
+    int64_t descartadas = 0;                         // instruções buscadas no caminho errado
+    int64_t encaminhamentos = 0;                     // LSQ: loads que receberam o dado de uma store
+    int64_t esperaOrdemMemoria = 0;                  // LSQ: ciclos de load esperando stores mais antigas
+    int64_t reexecucoes = 0;                         // LSQ especulativo: loads reexecutados por violação de ordem
+    int64_t esperaPipeline[NUM_CLASSES_UF] = {};     // PIPES: instruções prontas sem unidade livre
+    int classesComPipeline = 0;                      // bit k: classe k com PIPES
+    int modoLSQ = 0;
+    int64_t acessosL1 = 0;                           // cache: LD/SD que consultaram a L1 (encaminhados pelo LSQ não contam)
+    int64_t faltasL1 = 0;                            // inclui as mescladas num MSHR já aberto para a mesma linha
+    int64_t mesclagensMSHR = 0;
+    int64_t esperaMSHR = 0;                          // ciclos de acesso esperando um MSHR livre
+    int64_t despejosSujos = 0;                       // linhas modificadas devolvidas pela L1
+    int64_t acessosL2 = 0;
+    int64_t faltasL2 = 0;
+    int64_t somaLatenciaFaltas = 0;
+    int64_t faltasPorLatencia[NUM_FAIXAS_LATENCIA] = {}; // faixa k: latência de falta em [2^k, 2^(k+1))
+    int niveisCache = 0;                             // 0 sem cache, 1 só L1D, 2 com L2
+    int preditor = -1;                               // índice em NOMES_PREDITORES, -1 sem ROB
+    uint64_t bitsPreditor = 0;
+    std::unordered_map<int64_t, EstatisticaDesvio> porDesvio;
+};
+
+enum class TipoEvento : uint8_t { Emissao, FimExecucao, Escrita, Despacho }; // Despacho: da estação para um estágio de PIPES
+
+struct Evento {
+    int64_t ciclo;
+    int64_t posicao;
+    uint32_t nome; // id do texto da operação
+    uint32_t estacao;
+    TipoEvento tipo;
+};
+
+class RegistroEventos { // buffer circular de eventos (--eventos); cheio, sobrescreve os mais antigos
+public:
+    explicit RegistroEventos(size_t capacidade) : eventos(capacidade > 0 ? capacidade : 1) {}
+
+    void registra(const Evento& e) {
+        eventos[total % eventos.size()] = e;
+        total++;
+    }
+
+    template <typename F>
+    void percorre(F f) const { // do mais antigo ainda guardado ao mais novo
+        uint64_t inicio = total > eventos.size() ? total - eventos.size() : 0;
+        for (uint64_t i = inicio; i < total; ++i) f(eventos[i % eventos.size()]);
+    }
+
+    uint64_t perdidos() const { return total > eventos.size() ? total - eventos.size() : 0; }
+
+private:
+    std::vector<Evento> eventos;
+    uint64_t total = 0;
+};
+
+class MemoriaDados { // memória de dados esparsa em páginas de 4 KiB, criadas na primeira escrita; acessos de 8 bytes alinhados para baixo
+public:
+    static constexpr int BITS_PAGINA = 12;
+    static constexpr size_t PALAVRAS_PAGINA = (size_t(1) << BITS_PAGINA) / 8;
+
+    uint64_t le(uint64_t endereco) const {
+        auto it = paginas.find(endereco >> BITS_PAGINA);
+        return it != paginas.end() ? it->second->palavras[palavra(endereco)] : 0;
+    }
+
+    void escreve(uint64_t endereco, uint64_t valor, bool pontoFlutuante) {
+        std::unique_ptr<Pagina>& pagina = paginas[endereco >> BITS_PAGINA];
+        if (!pagina) pagina = std::make_unique<Pagina>();
+        size_t p = palavra(endereco);
+        pagina->palavras[p] = valor;
+        pagina->escrita[p] = true;
+        pagina->pontoFlutuante[p] = pontoFlutuante;
+    }
+
+    template <typename F>
+    void percorre(F f) const { // palavras já escritas em ordem de endereço: f(endereco, valor, pontoFlutuante)
+        std::vector<uint64_t> numeros;
+        for (const auto& e : paginas) numeros.push_back(e.first);
+        std::sort(numeros.begin(), numeros.end());
+        for (uint64_t n : numeros) {
+            const Pagina& pagina = *paginas.at(n);
+            for (size_t p = 0; p < PALAVRAS_PAGINA; ++p) {
+                if (pagina.escrita[p]) f((n << BITS_PAGINA) | (p * 8), pagina.palavras[p], static_cast<bool>(pagina.pontoFlutuante[p]));
+            }
+        }
+    }
+
+    size_t numPaginas() const { return paginas.size(); }
+
+    void serializa(ArquivoEstado& a) { // páginas em ordem de endereço; os bitsets vão como palavras de 64 bits
+        std::vector<uint64_t> numeros;
+        for (const auto& e : paginas) numeros.push_back(e.first);
+        std::sort(numeros.begin(), numeros.end());
+        a.campo(numeros);
+        if (a.lendo()) paginas.clear();
+        for (uint64_t n : numeros) {
+            if (!a.ok()) return; // não cria páginas para números lidos de um arquivo truncado
+            std::unique_ptr<Pagina>& pagina = paginas[n];
+            if (!pagina) pagina = std::make_unique<Pagina>();
+            a.campo(pagina->palavras);
+            for (auto* conjunto : {&pagina->escrita, &pagina->pontoFlutuante}) {
+                uint64_t bits[PALAVRAS_PAGINA / 64] = {};
+                for (size_t p = 0; p < PALAVRAS_PAGINA; ++p) bits[p / 64] |= uint64_t((*conjunto)[p]) << (p % 64);
+                a.campo(bits);
+                for (size_t p = 0; p < PALAVRAS_PAGINA; ++p) (*conjunto)[p] = (bits[p / 64] >> (p % 64)) & 1;
+            }
+        }
+    }
+
+private:
+    struct Pagina {
+        uint64_t palavras[PALAVRAS_PAGINA] = {};
+        std::bitset<PALAVRAS_PAGINA> escrita;
+        std::bitset<PALAVRAS_PAGINA> pontoFlutuante; // só para a impressão
+    };
+    std::unordered_map<uint64_t, std::unique_ptr<Pagina>> paginas;
+
+    static size_t palavra(uint64_t endereco) { return (endereco >> 3) & (PALAVRAS_PAGINA - 1); }
+};
+
+inline uint64_t mascaraBits(int bits) { return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1; }
+
+inline int log2Inteiro(uint64_t v) { // piso; 0 para v = 0
+    int b = 0;
+    while (v >>= 1) ++b;
+    return b;
+}
+
+// cache associativa por conjunto, só de tags: linhas, bits de sujeira e estado de substituição em vetores contíguos,
+// o conjunto c nas posições [c * vias, (c + 1) * vias); o número de conjuntos é arredondado para potência de 2
+class Cache {
+public:
+    Cache(uint64_t tamanho, int viasPedidas, uint64_t bytesLinha, PoliticaCache politica) : politica(politica) {
+        vias = std::max(1, viasPedidas);
+        if (politica == PoliticaCache::Plru) vias = 1 << log2Inteiro(vias); // a árvore precisa de potência de 2
+        uint64_t conjuntos = uint64_t(1) << log2Inteiro(std::max<uint64_t>(1, tamanho / (bytesLinha * vias)));
+        mascaraConjunto = conjuntos - 1;
+        linhas.assign(conjuntos * vias, 0);
+        sujo.assign(conjuntos * vias, 0);
+        if (politica == PoliticaCache::Lru) {
+            idade.resize(conjuntos * vias);
+            for (size_t i = 0; i < idade.size(); ++i) idade[i] = static_cast<uint8_t>(i % vias);
+        } else {
+            arvore.assign(conjuntos, 0);
+        }
+    }
+
+    bool contem(uint64_t linha) const { return via(linha) >= 0; }
+
+    // consulta a linha; numa falta, ela entra no lugar da vítima, e despejada recebe a vítima suja + 1 (0 se nenhuma)
+    bool acessa(uint64_t linha, bool escrita, uint64_t& despejada) {
+        size_t conjunto = linha & mascaraConjunto;
+        size_t base = conjunto * vias;
+        int w = via(linha);
+        bool acerto = w >= 0;
+        despejada = 0;
+        if (!acerto) {
+            w = vitima(conjunto);
+            if (linhas[base + w] != 0 && sujo[base + w]) despejada = linhas[base + w];
+            linhas[base + w] = linha + 1;
+            sujo[base + w] = 0;
+        }
+        if (escrita) sujo[base + w] = 1;
+        usa(conjunto, w);
+        return acerto;
+    }
+
+    void serializa(ArquivoEstado& a) {
+        a.campoFixo(linhas);
+        a.campoFixo(sujo);
+        a.campoFixo(idade);
+        a.campoFixo(arvore);
+    }
+
+private:
+    PoliticaCache politica;
+    int vias = 1;
+    uint64_t mascaraConjunto = 0;
+    std::vector<uint64_t> linhas;  // número da linha + 1; 0 = inválida
+    std::vector<uint8_t> sujo;
+    std::vector<uint8_t> idade;    // LRU: 0 = mais recente
+    std::vector<uint64_t> arvore;  // PLRU: um bit por nó interno (nó n no bit n, raiz em 1); o bit aponta o lado a despejar
+
+    int via(uint64_t linha) const {
+        size_t base = (linha & mascaraConjunto) * vias;
+        for (int w = 0; w < vias; ++w) {
+            if (linhas[base + w] == linha + 1) return w;
+        }
+        return -1;
+    }
+
+    int vitima(size_t conjunto) const { // uma via inválida, se houver
+        size_t base = conjunto * vias;
+        for (int w = 0; w < vias; ++w) {
+            if (linhas[base + w] == 0) return w;
+        }
+        if (politica == PoliticaCache::Lru) {
+            return static_cast<int>(std::max_element(idade.begin() + base, idade.begin() + base + vias) - (idade.begin() + base));
+        }
+        int w = 0;
+        for (int n = 1; n < vias;) {
+            int lado = static_cast<int>((arvore[conjunto] >> n) & 1);
+            w = 2 * w + lado;
+            n = 2 * n + lado;
+        }
+        return w;
+    }
+
+    void usa(size_t conjunto, int w) {
+        if (politica == PoliticaCache::Lru) {
+            size_t base = conjunto * vias;
+            for (int i = 0; i < vias; ++i) {
+                if (idade[base + i] < idade[base + w]) idade[base + i]++;
+            }
+            idade[base + w] = 0;
+            return;
+        }
+        int niveis = log2Inteiro(vias);
+        for (int nivel = 0, n = 1; nivel < niveis; ++nivel) { // aponta cada nó do caminho para o lado oposto ao usado
+            int lado = (w >> (niveis - 1 - nivel)) & 1;
+            arvore[conjunto] = (arvore[conjunto] & ~(uint64_t(1) << n)) | (uint64_t(!lado) << n);
+            n = 2 * n + lado;
+        }
+    }
+};
+
+struct RequisicaoLLC { // falta ou devolução da L1 de um núcleo, aplicada à LLC compartilhada na barreira seguinte
+    int64_t ciclo;
+    uint64_t linha;
+    bool devolucao;
+};
+
+// LLC compartilhada de um sistema multinúcleo (L2_SIZE/L2_ASSOC; sem ela, as faltas da L1 vão direto à DRAM). Durante
+// um quantum ela só é lida, por todos os núcleos ao mesmo tempo; cada núcleo anota as suas faltas e devoluções na própria
+// fila, sem trava, e a barreira as aplica em ordem de ciclo e de núcleo: o resultado não depende do número de threads
+class CacheCompartilhada {
+public:
+    explicit CacheCompartilhada(const ConfigSimulador& c) : latenciaL2(c.latenciaL2), latenciaDRAM(c.latenciaDRAM) {
+        if (c.tamanhoL2 > 0) llc = std::make_unique<Cache>(c.tamanhoL2, c.viasL2, c.tamanhoLinha, static_cast<PoliticaCache>(c.politicaCache));
+    }
+
+    int latencia(uint64_t linha) const { // somada ao acesso que falta na L1, com a LLC como estava no início do quantum
+        if (!llc) return latenciaDRAM;
+        return llc->contem(linha) ? latenciaL2 : latenciaL2 + latenciaDRAM;
+    }
+
+    void aplica(std::vector<std::vector<RequisicaoLLC>*> filas) { // esvazia as filas, na ordem (ciclo, núcleo)
+        ordenadas.clear();
+        for (auto* fila : filas) {
+            ordenadas.insert(ordenadas.end(), fila->begin(), fila->end());
+            fila->clear();
+        }
+        std::stable_sort(ordenadas.begin(), ordenadas.end(), [](const RequisicaoLLC& a, const RequisicaoLLC& b) { return a.ciclo < b.ciclo; });
+        for (const RequisicaoLLC& r : ordenadas) {
+            if (r.devolucao) devolucoes++;
+            else acessos++;
+            if (!llc) continue;
+            uint64_t ignorada;
+            if (!llc->acessa(r.linha, r.devolucao, ignorada) && !r.devolucao) faltas++;
+        }
+    }
+
+    int64_t acessos = 0;
+    int64_t faltas = 0;
+    int64_t devolucoes = 0;
+
+private:
+    std::unique_ptr<Cache> llc;
+    int latenciaL2;
+    int latenciaDRAM;
+    std::vector<RequisicaoLLC> ordenadas;
+};
+
+struct PortaLLC { // ligação de um núcleo com a LLC compartilhada
+    const CacheCompartilhada* llc = nullptr;
+    uint64_t espaco = 0; // somado às linhas: cada núcleo tem o seu espaço de endereços
+    std::vector<RequisicaoLLC> fila;
+};
+
+// L1D, L2 opcional e DRAM de latência fixa, só de tags; o acerto na L1 custa a latência de CYCLES Load/Store e cada
+// falta soma L2_LATENCY e, se faltar também na L2, DRAM_LATENCY. Escrita com alocação e devolução (write-back)
+class HierarquiaMemoria {
+public:
+    explicit HierarquiaMemoria(const ConfigSimulador& c)
+        : l1(c.tamanhoL1, c.viasL1, c.tamanhoLinha, static_cast<PoliticaCache>(c.politicaCache)), bitsLinha(log2Inteiro(c.tamanhoLinha)),
+          latenciaL2(c.latenciaL2), latenciaDRAM(c.latenciaDRAM), numMSHRs(static_cast<size_t>(c.numMSHRs)) {
+        if (c.tamanhoL2 > 0) l2 = std::make_unique<Cache>(c.tamanhoL2, c.viasL2, c.tamanhoLinha, static_cast<PoliticaCache>(c.politicaCache));
+        mshrs.reserve(numMSHRs);
+    }
+
+    bool temL2() const { return l2 != nullptr; }
+
+    void conecta(PortaLLC* p) { porta = p; } // multinúcleo: as faltas da L1 vão à LLC compartilhada, no lugar da L2
+
+    // ciclos a somar à latência de acerto; -1 se a falta não encontra MSHR livre e o acesso tem de tentar de novo
+    int acessa(uint64_t endereco, bool escrita, int64_t agora, Contadores* c) {
+        uint64_t linha = endereco >> bitsLinha;
+        mshrs.erase(std::remove_if(mshrs.begin(), mshrs.end(), [agora](const MSHR& m) { return m.pronto <= agora; }), mshrs.end());
+        uint64_t despejada = 0;
+        for (const MSHR& m : mshrs) {
+            if (m.linha != linha) continue;
+            l1.acessa(linha, escrita, despejada); // a linha já foi instalada pela falta primária
+            int restante = static_cast<int>(m.pronto - agora);
+            if (c) {
+                c->acessosL1++;
+                c->mesclagensMSHR++;
+                registraFalta(*c, restante);
+            }
+            return restante;
+        }
+        if (mshrs.size() >= numMSHRs && !l1.contem(linha)) return -1;
+        if (c) c->acessosL1++;
+        if (l1.acessa(linha, escrita, despejada)) return 0;
+        if (despejada != 0) {
+            if (porta) {
+                porta->fila.push_back({agora, (despejada - 1) + porta->espaco, true});
+            } else if (l2) {
+                uint64_t ignorada;
+                l2->acessa(despejada - 1, true, ignorada);
+            }
+            if (c) c->despejosSujos++;
+        }
+        int latencia = latenciaDRAM;
+        if (porta) {
+            latencia = porta->llc->latencia(linha + porta->espaco);
+            porta->fila.push_back({agora, linha + porta->espaco, false});
+        } else if (l2) {
+            latencia = latenciaL2;
+            bool acertoL2 = l2->acessa(linha, false, despejada);
+            if (!acertoL2) latencia += latenciaDRAM;
+            if (c) {
+                c->acessosL2++;
+                if (!acertoL2) c->faltasL2++;
+            }
+        }
+        if (latencia > 0) mshrs.push_back({linha, agora + latencia});
+        if (c) registraFalta(*c, latencia);
+        return latencia;
+    }
+
+    void aquece(uint64_t endereco, bool escrita) { // avanço funcional: só o conteúdo das caches, sem tempo, MSHRs nem contadores
+        uint64_t linha = endereco >> bitsLinha;
+        uint64_t despejada = 0;
+        if (l1.acessa(linha, escrita, despejada)) return;
+        if (porta) { // aplicadas antes do primeiro quantum
+            if (despejada != 0) porta->fila.push_back({0, (despejada - 1) + porta->espaco, true});
+            porta->fila.push_back({0, linha + porta->espaco, false});
+            return;
+        }
+        if (!l2) return;
+        uint64_t ignorada;
+        if (despejada != 0) l2->acessa(despejada - 1, true, ignorada);
+        l2->acessa(linha, false, ignorada);
+    }
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(l1);
+        if (l2) a.campo(*l2);
+        a.campo(mshrs);
+        if (mshrs.size() > numMSHRs) a.falha();
+    }
+
+private:
+    struct MSHR {
+        uint64_t linha;
+        int64_t pronto; // ciclo em que a linha chega à L1
+
+        void serializa(ArquivoEstado& a) {
+            a.campo(linha);
+            a.campo(pronto);
+        }
+    };
+    Cache l1;
+    std::unique_ptr<Cache> l2;
+    int bitsLinha;
+    int latenciaL2;
+    int latenciaDRAM;
+    size_t numMSHRs;
+    std::vector<MSHR> mshrs;
+    PortaLLC* porta = nullptr;
+
+    static void registraFalta(Contadores& c, int latencia) {
+        c.faltasL1++;
+        c.somaLatenciaFaltas += latencia;
+        c.faltasPorLatencia[std::min(log2Inteiro(static_cast<uint64_t>(latencia)), NUM_FAIXAS_LATENCIA - 1)]++;
+    }
+};
+
+class ContadoresSaturados { // contadores de 2 bits, quatro por byte; começam em 1 (fracamente não tomado)
+public:
+    explicit ContadoresSaturados(int bitsIndice) : mascara(mascaraBits(bitsIndice)), bytes((mascara + 4) / 4, 0x55) {}
+
+    bool tomado(uint64_t i) const { return le(i & mascara) >= 2; }
+
+    void atualiza(uint64_t i, bool tomado) {
+        i &= mascara;
+        int c = le(i);
+        if (tomado && c < 3) c++;
+        else if (!tomado && c > 0) c--;
+        int deslocamento = 2 * (i % 4);
+        bytes[i / 4] = static_cast<uint8_t>((bytes[i / 4] & ~(3 << deslocamento)) | (c << deslocamento));
+    }
+
+    uint64_t bits() const { return 2 * (mascara + 1); }
+
+    void serializa(ArquivoEstado& a) { a.campoFixo(bytes); }
+
+private:
+    uint64_t mascara;
+    std::vector<uint8_t> bytes;
+
+    int le(uint64_t i) const { return (bytes[i / 4] >> (2 * (i % 4))) & 3; }
+};
+
+class PreditorDesvios { // consultado na busca de BEQ/BNEZ e treinado na efetivação; o histórico global (1 = tomado) fica com o Estado
+public:
+    virtual ~PreditorDesvios() = default;
+    virtual bool preve(int64_t pc, uint64_t historico) const = 0;
+    virtual void atualiza(int64_t pc, uint64_t historico, bool tomado) = 0;
+    virtual uint64_t bitsArmazenamento() const = 0;
+    virtual void serializa(ArquivoEstado& a) = 0; // as tabelas; o tamanho vem da configuração
+};
+
+class PreditorEstatico : public PreditorDesvios { // sempre não tomado
+public:
+    bool preve(int64_t, uint64_t) const override { return false; }
+    void atualiza(int64_t, uint64_t, bool) override {}
+    uint64_t bitsArmazenamento() const override { return 0; }
+    void serializa(ArquivoEstado&) override {}
+};
+
+class PreditorBimodal : public PreditorDesvios { // contador de 2 bits indexado pelo pc
+public:
+    explicit PreditorBimodal(int bits) : contadores(bits) {}
+    bool preve(int64_t pc, uint64_t) const override { return contadores.tomado(static_cast<uint64_t>(pc)); }
+    void atualiza(int64_t pc, uint64_t, bool tomado) override { contadores.atualiza(static_cast<uint64_t>(pc), tomado); }
+    uint64_t bitsArmazenamento() const override { return contadores.bits(); }
+    void serializa(ArquivoEstado& a) override { a.campo(contadores); }
+
+private:
+    ContadoresSaturados contadores;
+};
+
+class PreditorGshare : public PreditorDesvios { // contador de 2 bits indexado por pc XOR histórico global
+public:
+    PreditorGshare(int bits, int bitsHistorico) : contadores(bits), bitsHistorico(bitsHistorico) {}
+    bool preve(int64_t pc, uint64_t historico) const override { return contadores.tomado(indice(pc, historico)); }
+    void atualiza(int64_t pc, uint64_t historico, bool tomado) override { contadores.atualiza(indice(pc, historico), tomado); }
+    uint64_t bitsArmazenamento() const override { return contadores.bits() + bitsHistorico; }
+    void serializa(ArquivoEstado& a) override { a.campo(contadores); }
+
+private:
+    ContadoresSaturados contadores;
+    int bitsHistorico;
+
+    uint64_t indice(int64_t pc, uint64_t historico) const { return static_cast<uint64_t>(pc) ^ (historico & mascaraBits(bitsHistorico)); }
+};
+
+class PreditorTage : public PreditorDesvios { // TAGE reduzido: base bimodal e tabelas com tag de históricos geométricos até HISTORY_BITS
+public:
+    static constexpr int NUM_TABELAS = 4;
+    static constexpr int BITS_TAG = 8;
+
+    PreditorTage(int bits, int bitsHistorico) : base(bits), bitsIndice(std::max(bits - 2, 1)), bitsHistorico(bitsHistorico) {
+        for (int t = 0; t < NUM_TABELAS; ++t) {
+            comprimento[t] = std::max(1, bitsHistorico >> (NUM_TABELAS - 1 - t));
+            tabelas[t].resize(size_t(1) << bitsIndice);
+        }
+    }
+
+    bool preve(int64_t pc, uint64_t historico) const override { return consulta(pc, historico).previsao; }
+
+    void atualiza(int64_t pc, uint64_t historico, bool tomado) override {
+        Consulta c = consulta(pc, historico);
+        if (c.provedora >= 0) {
+            Entrada& e = tabelas[c.provedora][c.indices[c.provedora]];
+            if (c.previsao != c.alternativa) { // a entrada só é útil quando decide contra a alternativa
+                if (c.previsao == tomado && e.util < 3) e.util++;
+                else if (c.previsao != tomado && e.util > 0) e.util--;
+            }
+            e.contador = static_cast<int8_t>(tomado ? std::min(e.contador + 1, 3) : std::max(e.contador - 1, -4));
+        } else {
+            base.atualiza(static_cast<uint64_t>(pc), tomado);
+        }
+        if (c.previsao != tomado) aloca(c, tomado);
+    }
+
+    uint64_t bitsArmazenamento() const override {
+        return base.bits() + NUM_TABELAS * (uint64_t(1) << bitsIndice) * (BITS_TAG + 3 + 2) + bitsHistorico;
+    }
+
+    void serializa(ArquivoEstado& a) override {
+        a.campo(base);
+        for (auto& t : tabelas) a.campoFixo(t);
+    }
+
+private:
+    struct Entrada {
+        uint8_t tag = 0;      // 0 = vazia
+        int8_t contador = 0;  // 3 bits com sinal: >= 0 prevê tomado
+        uint8_t util = 0;     // 2 bits
+
+        void serializa(ArquivoEstado& a) {
+            a.campo(tag);
+            a.campo(contador);
+            a.campo(util);
+        }
+    };
+    struct Consulta {
+        uint64_t indices[NUM_TABELAS];
+        uint8_t tags[NUM_TABELAS];
+        int provedora = -1; // tabela de histórico mais longo com a tag, -1 se só a base
+        bool previsao = false;
+        bool alternativa = false; // previsão sem a provedora
+    };
+
+    ContadoresSaturados base;
+    std::vector<Entrada> tabelas[NUM_TABELAS];
+    int comprimento[NUM_TABELAS];
+    int bitsIndice;
+    int bitsHistorico;
+
+    static uint64_t dobra(uint64_t h, int bits) { // reduz o histórico a bits por XOR dos pedaços
+        uint64_t r = 0;
+        for (; h; h >>= bits) r ^= h & mascaraBits(bits);
+        return r;
+    }
+
+    Consulta consulta(int64_t pc, uint64_t historico) const {
+        Consulta c;
+        uint64_t endereco = static_cast<uint64_t>(pc);
+        for (int t = 0; t < NUM_TABELAS; ++t) {
+            uint64_t h = historico & mascaraBits(comprimento[t]);
+            c.indices[t] = (endereco ^ (endereco >> bitsIndice) ^ dobra(h, bitsIndice) ^ t) & mascaraBits(bitsIndice);
+            c.tags[t] = static_cast<uint8_t>(1 + (endereco ^ dobra(h, BITS_TAG) ^ (dobra(h, BITS_TAG - 1) << 1)) % 255);
+        }
+        c.alternativa = base.tomado(endereco);
+        int alternativa = -1;
+        for (int t = NUM_TABELAS; t-- > 0;) {
+            if (tabelas[t][c.indices[t]].tag != c.tags[t]) continue;
+            if (c.provedora < 0) {
+                c.provedora = t;
+            } else {
+                alternativa = t;
+                break;
+            }
+        }
+        if (alternativa >= 0) c.alternativa = tabelas[alternativa][c.indices[alternativa]].contador >= 0;
+        c.previsao = c.provedora >= 0 ? tabelas[c.provedora][c.indices[c.provedora]].contador >= 0 : c.alternativa;
+        return c;
+    }
+
+    void aloca(const Consulta& c, bool tomado) { // numa tabela mais longa que a provedora, na primeira entrada não útil
+        for (int t = c.provedora + 1; t < NUM_TABELAS; ++t) {
+            Entrada& e = tabelas[t][c.indices[t]];
+            if (e.util == 0) {
+                e = {c.tags[t], static_cast<int8_t>(tomado ? 0 : -1), 0};
+                return;
+            }
+        }
+        for (int t = c.provedora + 1; t < NUM_TABELAS; ++t) tabelas[t][c.indices[t]].util--;
+    }
+};
+
+std::unique_ptr<PreditorDesvios> criaPreditor(const ConfigSimulador& config) {
+    switch (static_cast<TipoPreditor>(config.preditor)) {
+        case TipoPreditor::Bimodal: return std::make_unique<PreditorBimodal>(config.bitsPreditor);
+        case TipoPreditor::Gshare: return std::make_unique<PreditorGshare>(config.bitsPreditor, config.bitsHistorico);
+        case TipoPreditor::Tage: return std::make_unique<PreditorTage>(config.bitsPreditor, config.bitsHistorico);
+        default: return std::make_unique<PreditorEstatico>();
+    }
+}
+
+struct EstacoesReserva { // estações em struct-of-arrays; a tag de uma estação é o seu índice
+    size_t numAritmeticas = 0; // [0, numAritmeticas): aritméticas/inteiro; [numAritmeticas, size()): buffers de memória
+    size_t inicioEstagios = 0; // [inicioEstagios, numAritmeticas): estágios das unidades de PIPES, que não recebem emissão
+    std::vector<std::string> nome;
+    std::vector<ClasseUF> classe;
+    std::vector<uint8_t> ocupado;
+    std::vector<int32_t> tempo;
+    std::vector<int32_t> instrucao; // índice em estadoInstrucoes, -1 se livre
+    std::vector<uint32_t> q1;       // aritméticas: Qj; memória: Qi
+    std::vector<uint32_t> q2;       // aritméticas: Qk; memória: Qj (base)
+    std::vector<TipoOperando> v1Tipo, v2Tipo;
+    std::vector<uint32_t> v1, v2;
+    std::vector<int32_t> primeiraEspera; // por produtora: primeira vaga (2 * consumidora + operando) à espera do seu resultado, -1 se nenhuma
+    std::vector<int32_t> proximaEspera;  // por vaga: próxima vaga na lista da mesma produtora
+    std::vector<uint64_t> ocupadas;      // bit s: ocupado[s]; os laços por ciclo percorrem só as estações ocupadas
+    int32_t livres[NUM_CLASSES_UF] = {}; // estações livres que recebem emissão (sem os estágios de PIPES), por classe
+    std::vector<uint64_t> livresDaClasse[NUM_CLASSES_UF]; // bit s: estação livre da classe que recebe emissão
+
+    size_t size() const { return nome.size(); }
+
+    void marca(size_t s, bool ocupada) { // o único ponto que muda ocupado, para manter ocupadas e livres em dia
+        if (ocupado[s] == ocupada) return;
+        ocupado[s] = ocupada;
+        ocupadas[s / 64] ^= uint64_t(1) << (s % 64);
+        if (estagio(s) || classe[s] == ClasseUF::Nenhuma) return;
+        int c = static_cast<int>(classe[s]);
+        livres[c] += ocupada ? -1 : 1;
+        livresDaClasse[c][s / 64] ^= uint64_t(1) << (s % 64);
+    }
+
+    size_t proximaOcupada(size_t s) const { // primeira estação ocupada a partir de s; size() se nenhuma
+        size_t w = s / 64;
+        if (w >= ocupadas.size()) return size();
+        uint64_t resto = ocupadas[w] & (~uint64_t(0) << (s % 64));
+        while (resto == 0) {
+            if (++w == ocupadas.size()) return size();
+            resto = ocupadas[w];
+        }
+        return w * 64 + static_cast<size_t>(__builtin_ctzll(resto));
+    }
+
+    size_t primeiraLivre(ClasseUF c, size_t s) const { // primeira estação livre da classe a partir de s; size() se nenhuma
+        const std::vector<uint64_t>& bits = livresDaClasse[static_cast<int>(c)];
+        if (livres[static_cast<int>(c)] == 0 || s / 64 >= bits.size()) return size();
+        size_t w = s / 64;
+        uint64_t resto = bits[w] & (~uint64_t(0) << (s % 64));
+        while (resto == 0) {
+            if (++w == bits.size()) return size();
+            resto = bits[w];
+        }
+        return w * 64 + static_cast<size_t>(__builtin_ctzll(resto));
+    }
+
+    void refazOcupadas() { // a partir de ocupado: na criação (quando os limites já são conhecidos) e ao restaurar
+        ocupadas.assign((size() + 63) / 64, 0);
+        for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+            livres[c] = 0;
+            livresDaClasse[c].assign(ocupadas.size(), 0);
+        }
+        for (size_t s = 0; s < size(); ++s) {
+            if (ocupado[s]) {
+                ocupadas[s / 64] |= uint64_t(1) << (s % 64);
+            } else if (!estagio(s) && classe[s] != ClasseUF::Nenhuma) {
+                livres[static_cast<int>(classe[s])]++;
+                livresDaClasse[static_cast<int>(classe[s])][s / 64] |= uint64_t(1) << (s % 64);
+            }
+        }
+    }
+
+    bool estagio(size_t s) const { return s >= inicioEstagios && s < numAritmeticas; }
+
+    void adiciona(const std::string& nomeEstacao, ClasseUF classeEstacao) {
+        nome.push_back(nomeEstacao);
+        classe.push_back(classeEstacao);
+        ocupado.push_back(0);
+        tempo.push_back(SEM_TEMPO);
+        instrucao.push_back(-1);
+        q1.push_back(SEM_TAG);
+        q2.push_back(SEM_TAG);
+        v1Tipo.push_back(TipoOperando::Vazio);
+        v2Tipo.push_back(TipoOperando::Vazio);
+        v1.push_back(0);
+        v2.push_back(0);
+        primeiraEspera.push_back(-1);
+        proximaEspera.push_back(-1);
+        proximaEspera.push_back(-1);
+    }
+
+    void aguarda(size_t consumidora, int operando, uint32_t produtora) { // encadeia a vaga na lista da produtora
+        int32_t vaga = static_cast<int32_t>(2 * consumidora + operando);
+        proximaEspera[vaga] = primeiraEspera[produtora];
+        primeiraEspera[produtora] = vaga;
+    }
+
+    void serializa(ArquivoEstado& a) { // só o estado dinâmico: nomes e classes vêm da configuração
+        a.campoFixo(ocupado);
+        a.campoFixo(tempo);
+        a.campoFixo(instrucao);
+        a.campoFixo(q1);
+        a.campoFixo(q2);
+        a.campoFixo(v1Tipo);
+        a.campoFixo(v2Tipo);
+        a.campoFixo(v1);
+        a.campoFixo(v2);
+        a.campoFixo(primeiraEspera);
+        a.campoFixo(proximaEspera);
+        if (a.lendo() && a.ok() && !consistente()) a.falha();
+        if (a.ok()) refazOcupadas();
+    }
+
+    bool consistente() const { // tags e listas de espera lidas de um checkpoint; as vagas em instrucao, o Estado confere
+        std::vector<uint8_t> vista(2 * size(), 0);
+        for (size_t s = 0; s < size(); ++s) {
+            if (ocupado[s] > 1 || (q1[s] != SEM_TAG && q1[s] >= size()) || (q2[s] != SEM_TAG && q2[s] >= size())) return false;
+            if (v1Tipo[s] > TipoOperando::Valor || (v1Tipo[s] == TipoOperando::Valor && v1[s] >= size())) return false;
+            if (v2Tipo[s] > TipoOperando::Valor || (v2Tipo[s] == TipoOperando::Valor && v2[s] >= size())) return false;
+            for (int32_t v = primeiraEspera[s]; v != -1; v = proximaEspera[v]) {
+                if (v < 0 || static_cast<size_t>(v) >= vista.size() || vista[v]) return false; // fora da tabela, ou um ciclo
+                vista[v] = 1;
+            }
+        }
+        return true;
+    }
+
+    void refazEsperas() { // reconstrói as listas a partir de Qj/Qk, depois de descartar estações
+        std::fill(primeiraEspera.begin(), primeiraEspera.end(), -1);
+        for (size_t s = 0; s < size(); ++s) {
+            if (!ocupado[s]) continue;
+            if (q1[s] != SEM_TAG) aguarda(s, 0, q1[s]);
+            if (q2[s] != SEM_TAG) aguarda(s, 1, q2[s]);
+        }
+    }
+};
+
+struct TabelaRegistradores { // estação de registradores indexada por id de registrador
+    std::vector<EstadoRegistrador> estado;
+    std::vector<uint32_t> tag;
+    std::vector<uint8_t> visivel; // registradores fora do conjunto inicial só aparecem depois de escritos
+    std::vector<uint64_t> valor;  // execução funcional: valor arquitetural (bits)
+    std::vector<uint8_t> pontoFlutuante;
+    std::vector<uint8_t> zero;    // R0: sempre 0
+    std::vector<uint32_t> geracao; // renomeações do registrador: identifica o valor da base nos endereços simbólicos do LSQ
+
+    size_t size() const { return estado.size(); }
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(estado);
+        a.campo(tag);
+        a.campo(visivel);
+        a.campo(valor);
+        a.campo(pontoFlutuante);
+        a.campo(zero);
+        a.campo(geracao);
+        for (size_t n : {tag.size(), visivel.size(), valor.size(), pontoFlutuante.size(), zero.size(), geracao.size()}) {
+            if (n != size()) a.falha();
+        }
+    }
+};
+
+struct RecursosCompartilhados { // SMT: estações e unidades de PIPES de um núcleo, disputadas por todos os seus contextos
+    int estacoesLivres[NUM_CLASSES_UF] = {};
+    std::vector<int64_t> ultimaEntrada[NUM_CLASSES_UF]; // como em PipelinesClasse
+};
+
+class Estado {
+public:
+    ConfigSimulador config;
+    std::shared_ptr<const ProgramaDecodificado> programa;
+    std::vector<EstadoInstrucao> estadoInstrucoes; // todas as instruções ou, com uma fonte, só a janela em voo
+    EstacoesReserva estacoes;
+    TabelaRegistradores registradores;
+    int64_t clock_cycle;
+    std::vector<DestinoResultados*> destinosResultados;
+    MemoriaDados memoria; // execução funcional (FUNCTIONAL 1)
+    Contadores* contadores = nullptr;  // instrumentação opcional: nula, custa só um teste por ponto de coleta
+    RegistroEventos* eventos = nullptr;
+    RecursosCompartilhados* compartilhados = nullptr; // SMT: nulo com um único contexto
+
+    // sem fonte, todas as instruções de prog ficam em estadoInstrucoes até o fim (como impresso por printEstadoDebug);
+    // com uma fonte, as instruções são buscadas sob demanda numa janela de tamanho fixo e liberadas ao escrever
+    Estado(const ConfigSimulador& cfg, std::shared_ptr<const ProgramaDecodificado> prog, std::unique_ptr<FonteInstrucoes> fonte = nullptr) // inicialização das instruções, registradores e unidades funcionais
+        : config(cfg), programa(std::move(prog)), clock_cycle(0), fonte(std::move(fonte)) {
+        for (int c = 0; c < NUM_CLASSES_UF; ++c) { // a latência vem da configuração, não do programa, que pode ser compartilhado entre configurações
+            auto it = config.ciclos.find(NOMES_CLASSES_UF[c]);
+            latencias[c] = it != config.ciclos.end() ? it->second : 1;
+        }
+        for (const auto& p : config.dados.memoria) memoria.escreve(p.endereco, p.valor, p.pontoFlutuante);
+        criaEstacoes(config.unidades);
+        estacoes.inicioEstagios = estacoes.size();
+        criaEstagios();
+        estacoes.numAritmeticas = estacoes.size();
+        criaEstacoes(config.unidadesMem);
+        estacoes.refazOcupadas();
+        prontas.reserve(estacoes.size()); // vetores de trabalho por ciclo: no máximo uma vez cada estação
+        candidatas.reserve(estacoes.size());
+        if (config.tamanhoL1 > 0 && config.funcional) cache = std::make_unique<HierarquiaMemoria>(config);
+
+        if (config.tamanhoROB > 0) {
+            rob.resize(config.tamanhoROB);
+            if (config.larguraCommit == 0) config.larguraCommit = config.larguraEmissao;
+            preditor = criaPreditor(config);
+            if (!this->fonte) this->fonte = std::make_unique<FontePrograma>(programa); // com desvios, uma instrução pode ser buscada várias vezes
+        }
+        if (this->fonte) {
+            criaJanela();
+        } else {
+            for (uint32_t i = 0; i < programa->instrucoes.size(); ++i) {
+                estadoInstrucoes.emplace_back(programa->instrucoes[i], i);
+            }
+            this->config.numInstrucoes = programa->instrucoes.size();
+        }
+        atualizaRegistradores();
+    }
+
+    // avanço funcional: as n próximas instruções só passam pelo modelo funcional (valores, memória, caminho dos desvios,
+    // treino do preditor e conteúdo das caches), sem ciclos; a simulação detalhada continua da seguinte. Só antes do
+    // primeiro ciclo. Retorna quantas foram avançadas (menos que n se o trace acabar); porInstrucao vê cada uma
+    template <typename F>
+    int64_t avancaFuncional(int64_t n, F&& porInstrucao) {
+        if (!fonte) { // o restante do programa passa a ser buscado numa janela, como com uma fonte
+            fonte = std::make_unique<FontePrograma>(programa);
+            criaJanela();
+        }
+        int64_t avancadas = 0;
+        InstrucaoDecodificada d;
+        while (avancadas < n && !fonteEsgotada) {
+            if (!fonte->proxima(d)) {
+                fonteEsgotada = true;
+                break;
+            }
+            EstadoInstrucao instr(d, buscadas++);
+            instr.pc = pcBusca++;
+            atualizaRegistradores();
+            if (config.funcional) executaFuncional(instr);
+            if (d.destino >= 0) {
+                registradores.geracao[d.destino]++;
+                registradores.visivel[d.destino] = 1;
+            }
+            if (cache && instr.enderecoReal) cache->aquece(instr.endereco, d.flags & ARMAZENA);
+            if (!rob.empty() && (d.flags & DESVIO)) {
+                aplicaPadrao(instr);
+                preditor->atualiza(instr.pc, historico, instr.tomado);
+                historico = (historico << 1) | instr.tomado;
+                if (instr.tomado) redirecionaBusca(programa->alvo(d, instr.pc));
+            }
+            porInstrucao(instr);
+            avancadas++;
+        }
+        return avancadas;
+    }
+
+    int64_t avancaFuncional(int64_t n) {
+        return avancaFuncional(n, [](const EstadoInstrucao&) {});
+    }
+
+    // checkpoint: todo o estado que muda durante a simulação; configuração, programa e instrumentação (contadores,
+    // eventos e destinos de resultados) ficam de fora e vêm de quem restaura
+    void serializa(ArquivoEstado& a) {
+        uint8_t janela = fonte != nullptr;
+        a.campo(janela);
+        if (a.lendo() && janela && !fonte) fonte = std::make_unique<FontePrograma>(programa); // checkpoint depois de --avanca
+        if (static_cast<bool>(janela) != (fonte != nullptr)) return a.falha();
+        a.campo(clock_cycle);
+        a.campo(estadoInstrucoes);
+        a.campo(estacoes);
+        a.campo(registradores);
+        a.campo(memoria);
+        a.campo(vagasLivres);
+        a.campo(proximaEmissao);
+        a.campo(proximaRetida);
+        a.campo(buscadas);
+        a.campo(emVoo);
+        a.campo(concluidas);
+        a.campo(escritas);
+        a.campo(motivoEmissao);
+        a.campo(classeBloqueada);
+        a.campo(fonteEsgotada);
+        a.campo(rob);
+        a.campo(robInicio);
+        a.campo(robOcupadas);
+        a.campo(pcBusca);
+        if (preditor) a.campo(*preditor);
+        if (cache) a.campo(*cache);
+        for (auto& p : pipelines) a.campoFixo(p.ultimaEntrada);
+        a.campo(desvioErrado);
+        a.campo(historico);
+        a.campo(execucoesDesvio);
+        if (!a.lendo() || !a.ok()) return;
+        if (rob.size() != static_cast<size_t>(config.tamanhoROB)) return a.falha();
+        if (fonte && !fonte->posiciona(pcBusca)) { // fonte sequencial (sem ROB, pcBusca == buscadas): relê até o ponto
+            InstrucaoDecodificada d;
+            for (int64_t i = 0; i < pcBusca && fonte->proxima(d); ++i) {}
+        }
+        atualizaRegistradores(); // a impressão percorre todos os registradores do programa
+        if (!consistente()) a.falha();
+    }
+
+    bool consistente() const { // índices lidos de um checkpoint, conferidos antes de a simulação indexar tabelas com eles
+        int64_t vagas = static_cast<int64_t>(estadoInstrucoes.size());
+        size_t numNomes = programa->nomes.size(), numRegistradores = registradores.size();
+        auto vaga = [&](int64_t v) { return v >= -1 && v < vagas; };
+        auto tag = [&](uint32_t t) { return t == SEM_TAG || t < estacoes.size(); };
+        auto literal = [&](TipoOperando tipo, uint32_t v) { return tipo != TipoOperando::Literal || v == SEM_ID || v < numNomes; };
+        for (const EstadoInstrucao& e : estadoInstrucoes) {
+            if (!e.instrucao.consistente(numNomes, numRegistradores)) return false;
+        }
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            if (!vaga(estacoes.instrucao[s]) || (estacoes.ocupado[s] && estacoes.instrucao[s] < 0)) return false;
+            if (!literal(estacoes.v1Tipo[s], estacoes.v1[s]) || !literal(estacoes.v2Tipo[s], estacoes.v2[s])) return false;
+        }
+        for (size_t r = 0; r < numRegistradores; ++r) {
+            if (registradores.estado[r] > EstadoRegistrador::Valor || !tag(registradores.tag[r])) return false;
+        }
+        for (int32_t v : vagasLivres) {
+            if (v < 0 || !vaga(v)) return false;
+        }
+        if (!vaga(proximaEmissao) || !vaga(desvioErrado)) return false;
+        if (static_cast<int>(motivoEmissao) >= NUM_MOTIVOS_EMISSAO || classeBloqueada > ClasseUF::Nenhuma) return false;
+        if (robOcupadas > rob.size() || (!rob.empty() && robInicio >= rob.size())) return false;
+        for (size_t i = 0; i < rob.size(); ++i) {
+            const EntradaROB& e = rob[i];
+            bool ocupada = (i + rob.size() - robInicio) % rob.size() < robOcupadas;
+            if (!vaga(e.vaga) || (ocupada && e.vaga < 0) || e.estadoAnterior > EstadoRegistrador::Valor || !tag(e.tagAnterior)) return false;
+            if (e.destino < -1 || (e.destino >= 0 && static_cast<size_t>(e.destino) >= numRegistradores)) return false;
+        }
+        return true;
+    }
+
+    // incremental: restaura um estado gravado com outra disposição de estações (UNITS, MEM_UNITS ou, com PIPES, a
+    // latência mudaram). As estações são casadas pelo nome; as que só existem de um dos lados são de classes que o
+    // estado gravado ainda não usou, e por isso estão livres. Sem ROB, a janela acompanha o número de estações
+    bool restauraOutraDisposicao(ArquivoEstado& a, const EstacoesReserva& disposicao) {
+        EstacoesReserva nova = estacoes;
+        size_t janela = estadoInstrucoes.size();
+        estacoes = disposicao;
+        serializa(a);
+        if (!a.ok()) return false;
+        std::unordered_map<std::string, uint32_t> porNome;
+        for (size_t s = 0; s < nova.size(); ++s) porNome[nova.nome[s]] = static_cast<uint32_t>(s);
+        std::vector<uint32_t> mapa(estacoes.size(), SEM_TAG); // índice antigo -> novo
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            auto it = porNome.find(estacoes.nome[s]);
+            if (it != porNome.end() && nova.classe[it->second] == estacoes.classe[s] && nova.estagio(it->second) == estacoes.estagio(s) &&
+                (it->second >= nova.numAritmeticas) == (s >= estacoes.numAritmeticas)) {
+                mapa[s] = it->second;
+            } else if (estacoes.ocupado[s]) {
+                return false;
+            }
+        }
+        auto remapeia = [&](uint32_t tag) { return tag == SEM_TAG || tag >= mapa.size() ? SEM_TAG : mapa[tag]; };
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            uint32_t n = mapa[s];
+            if (n == SEM_TAG) continue;
+            nova.ocupado[n] = estacoes.ocupado[s];
+            nova.tempo[n] = estacoes.tempo[s];
+            nova.instrucao[n] = estacoes.instrucao[s];
+            nova.q1[n] = remapeia(estacoes.q1[s]);
+            nova.q2[n] = remapeia(estacoes.q2[s]);
+            nova.v1Tipo[n] = estacoes.v1Tipo[s];
+            nova.v2Tipo[n] = estacoes.v2Tipo[s];
+            nova.v1[n] = estacoes.v1Tipo[s] == TipoOperando::Valor ? remapeia(static_cast<uint32_t>(estacoes.v1[s])) : estacoes.v1[s];
+            nova.v2[n] = estacoes.v2Tipo[s] == TipoOperando::Valor ? remapeia(static_cast<uint32_t>(estacoes.v2[s])) : estacoes.v2[s];
+        }
+        estacoes = std::move(nova);
+        estacoes.refazOcupadas();
+        estacoes.refazEsperas();
+        for (uint32_t& t : registradores.tag) t = remapeia(t);
+        for (EntradaROB& e : rob) e.tagAnterior = remapeia(e.tagAnterior);
+        if (rob.empty() && janela != estadoInstrucoes.size()) { // as vagas em uso cabem: no máximo uma por estação ocupada e a próxima a emitir
+            std::vector<EstadoInstrucao> antigas = std::move(estadoInstrucoes);
+            estadoInstrucoes.assign(janela, EstadoInstrucao());
+            std::vector<int32_t> vaga(antigas.size(), -1);
+            size_t livre = 0;
+            for (size_t v = 0; v < antigas.size(); ++v) {
+                if (!antigas[v].ativa) continue;
+                while (livre < janela && estadoInstrucoes[livre].ativa) livre++;
+                if (livre == janela) return false;
+                vaga[v] = static_cast<int32_t>(livre);
+                estadoInstrucoes[livre] = antigas[v];
+            }
+            for (size_t s = 0; s < estacoes.size(); ++s) {
+                if (estacoes.instrucao[s] >= 0) estacoes.instrucao[s] = vaga[estacoes.instrucao[s]];
+            }
+            if (proximaEmissao >= 0) proximaEmissao = vaga[proximaEmissao];
+            vagasLivres.clear();
+            for (size_t v = janela; v-- > 0;) {
+                if (!estadoInstrucoes[v].ativa) vagasLivres.push_back(static_cast<int32_t>(v));
+            }
+        }
+        return true;
+    }
+
+    // incremental: a partir do registrador n, o estado restaurado ainda não usou nenhum, e no trace editado eles podem
+    // ter outros nomes; volta-os ao valor inicial segundo a tabela atual
+    void recriaRegistradores(size_t n) {
+        if (n >= registradores.size()) return;
+        registradores.estado.resize(n);
+        registradores.tag.resize(n);
+        registradores.visivel.resize(n);
+        registradores.valor.resize(n);
+        registradores.pontoFlutuante.resize(n);
+        registradores.zero.resize(n);
+        registradores.geracao.resize(n);
+        atualizaRegistradores();
+    }
+
+    const InstrucaoDecodificada& decodificada(const EstadoInstrucao& s) const {
+        return s.instrucao;
+    }
+
+    EstadoInstrucao* getNovaInstrucao() { // retorna a próxima instrução que ainda não foi emitida, buscando-a se preciso
+        if (proximaEmissao < 0) buscaInstrucao();
+        return proximaEmissao >= 0 ? &estadoInstrucoes[proximaEmissao] : nullptr;
+    }
+
+    //getUFVazia: retorna o índice da estação livre da classe pedida, ou -1
+
+    int getFUVaziaArithInt(ClasseUF classe) const {
+        if (compartilhados && compartilhados->estacoesLivres[static_cast<int>(classe)] == 0) return -1;
+        size_t s = estacoes.primeiraLivre(classe, 0);
+        return s < estacoes.inicioEstagios ? static_cast<int>(s) : -1;
+    }
+
+    int getFUVaziaMem(ClasseUF classe) const {
+        if (compartilhados && compartilhados->estacoesLivres[static_cast<int>(classe)] == 0) return -1;
+        size_t s = estacoes.primeiraLivre(classe, estacoes.numAritmeticas);
+        return s < estacoes.size() ? static_cast<int>(s) : -1;
+    }
+
+    void alocaFU(size_t s, int idx) { // aloca uma unidade funcional para a instrução
+        const InstrucaoDecodificada& d = decodificada(estadoInstrucoes[idx]);
+        estacoes.instrucao[s] = idx;
+        estacoes.tempo[s] = latencias[static_cast<int>(d.classe)] + 1;
+        estacoes.marca(s, true);
+        estacoes.q1[s] = SEM_TAG;
+        estacoes.q2[s] = SEM_TAG;
+
+        if ((d.flags & CONTA_NA_EMISSAO) && estacoes.tempo[s] > 0) {
+            estacoes.tempo[s]--;
+        }
+
+        preparaOperando(d.fonteJ, estacoes.v1Tipo[s], estacoes.v1[s], estacoes.q1[s]);
+        preparaOperando(d.fonteK, estacoes.v2Tipo[s], estacoes.v2[s], estacoes.q2[s]);
+        if (estacoes.q1[s] != SEM_TAG) estacoes.aguarda(s, 0, estacoes.q1[s]);
+        if (estacoes.q2[s] != SEM_TAG) estacoes.aguarda(s, 1, estacoes.q2[s]);
+    }
+
+    void alocaFuMem(size_t s, int idx) { // aloca uma unidade funcional para a instrução
+        const InstrucaoDecodificada& d = decodificada(estadoInstrucoes[idx]);
+        estacoes.instrucao[s] = idx;
+        estacoes.tempo[s] = latencias[static_cast<int>(d.classe)] + 1;
+        estacoes.marca(s, true);
+        estacoes.q1[s] = SEM_TAG;
+        estacoes.q2[s] = SEM_TAG;
+
+        if (d.flags & ARMAZENA) {
+            estacoes.q1[s] = produtora(d.fonteJ.registrador);
+        }
+        estacoes.q2[s] = produtora(d.fonteK.registrador);
+        if (estacoes.q1[s] != SEM_TAG) estacoes.aguarda(s, 0, estacoes.q1[s]);
+        if (estacoes.q2[s] != SEM_TAG) estacoes.aguarda(s, 1, estacoes.q2[s]);
+
+        EstadoInstrucao& instr = estadoInstrucoes[idx];
+        if (config.modoLSQ && !instr.enderecoReal) { // endereço simbólico: mesmo registrador base, com o mesmo valor, e mesmo deslocamento
+            int32_t base = d.fonteK.registrador;
+            instr.baseEndereco = base >= 0 ? (uint64_t(1) << 63) | (static_cast<uint64_t>(base) << 32) | registradores.geracao[base] : ~uint64_t(0);
+            instr.endereco = static_cast<uint64_t>(d.imediato);
+        }
+    }
+
+    void escreveEstacaoRegistrador(const InstrucaoDecodificada& d, size_t s) { //informa ao registrador final qual unidade funcional irá lhe entregar o resultado da operação
+        if (d.destino >= 0) {
+            registradores.geracao[d.destino]++;
+            registradores.estado[d.destino] = EstadoRegistrador::Pendente;
+            registradores.tag[d.destino] = static_cast<uint32_t>(s);
+            registradores.visivel[d.destino] = 1;
+        }
+    }
+
+    void liberaUFEsperandoResultado(uint32_t tagQueTerminou) { //libera dependências que estavam esperando a liberação da unidade funcional, percorrendo só a lista de espera da produtora
+        int32_t vaga = estacoes.primeiraEspera[tagQueTerminou];
+        estacoes.primeiraEspera[tagQueTerminou] = -1;
+        while (vaga >= 0) {
+            size_t s = static_cast<size_t>(vaga) / 2;
+            bool primeiro = (vaga % 2) == 0;
+            vaga = estacoes.proximaEspera[vaga];
+
+            if (s < estacoes.numAritmeticas) {
+                if (primeiro) {
+                    estacoes.v1Tipo[s] = TipoOperando::Valor;
+                    estacoes.v1[s] = tagQueTerminou;
+                    estacoes.q1[s] = SEM_TAG;
+                } else {
+                    estacoes.v2Tipo[s] = TipoOperando::Valor;
+                    estacoes.v2[s] = tagQueTerminou;
+                    estacoes.q2[s] = SEM_TAG;
+                }
+                if (estacoes.q1[s] == SEM_TAG && estacoes.q2[s] == SEM_TAG && estacoes.tempo[s] > 0) {
+                    estacoes.tempo[s]--;
+                }
+            } else {
+                if (!primeiro && estacoes.q1[s] == tagQueTerminou) { // um buffer libera um operando por escrita: Qj fica para a próxima escrita desta estação
+                    estacoes.aguarda(s, 1, tagQueTerminou);
+                    continue;
+                }
+                (primeiro ? estacoes.q1[s] : estacoes.q2[s]) = SEM_TAG;
+                if (estacoes.tempo[s] > 0) {
+                    estacoes.tempo[s]--;
+                }
+                if (!primeiro && static_cast<ModoLSQ>(config.modoLSQ) == ModoLSQ::Especulativo && estacoes.classe[s] == ClasseUF::Store) {
+                    verificaViolacoes(s); // endereço da store conhecido agora
+                }
+            }
+        }
+    }
+
+    //limpeza das instruções e mudança dos status da unidades funcionais
+
+    void desalocaUF(size_t s) {
+        if (compartilhados && estacoes.ocupado[s] && !estacoes.estagio(s)) compartilhados->estacoesLivres[static_cast<int>(estacoes.classe[s])]++;
+        estacoes.instrucao[s] = -1;
+        estacoes.tempo[s] = SEM_TEMPO;
+        estacoes.marca(s, false);
+        estacoes.q1[s] = SEM_TAG;
+        estacoes.q2[s] = SEM_TAG;
+        estacoes.v1Tipo[s] = TipoOperando::Vazio;
+        estacoes.v2Tipo[s] = TipoOperando::Vazio;
+    }
+
+    bool verificaSeJaTerminou() { //retorna true se todas as instruções do arquivo de entrada tiverem escrito seus resultados
+        return fonteEsgotada && proximaEmissao < 0 && emVoo == 0;
+    }
+
+    bool vazio() { // true se não há nenhuma instrução para simular
+        return getNovaInstrucao() == nullptr && emVoo == 0;
+    }
+
+    bool programaVazio() { // vazio() para um Estado recém-criado, sem buscar: restaurar ou avançar exige a fonte no início
+        return fonte ? fonte->vazia() : estadoInstrucoes.empty();
+    }
+
+    int64_t instrucoesConcluidas() const { return concluidas; }
+
+    int64_t instrucoesEmVoo() const { return emVoo; }
+
+    void conectaLLC(PortaLLC& p) { // multinúcleo; sem cache (L1D_SIZE e FUNCTIONAL 1), o núcleo não acessa a LLC
+        if (cache) cache->conecta(&p);
+    }
+
+    RecursosCompartilhados recursos() const { // estações e unidades de PIPES deste núcleo, antes da primeira emissão
+        RecursosCompartilhados r;
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            if (!estacoes.estagio(s)) r.estacoesLivres[static_cast<int>(estacoes.classe[s])]++;
+        }
+        for (int c = 0; c < NUM_CLASSES_UF; ++c) r.ultimaEntrada[c] = pipelines[c].ultimaEntrada;
+        return r;
+    }
+
+    void ativaContadores(Contadores& c) {
+        contadores = &c;
+        c.modoLSQ = config.modoLSQ;
+        for (int k = 0; k < NUM_CLASSES_UF; ++k) {
+            if (!pipelines[k].ultimaEntrada.empty()) c.classesComPipeline |= 1 << k;
+        }
+        c.niveisCache = cache ? (cache->temL2() ? 2 : 1) : 0;
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            if (!estacoes.estagio(s)) c.estacoesPorClasse[static_cast<int>(estacoes.classe[s])]++;
+        }
+        if (preditor) {
+            c.preditor = config.preditor;
+            c.bitsPreditor = preditor->bitsArmazenamento();
+        }
+    }
+
+    void resultadosEmAberto(std::vector<ResultadoInstrucao>& out) const { // instruções buscadas que ainda não escreveram
+        for (const auto& s : estadoInstrucoes) {
+            if (s.ativa && !s.write.has_value()) out.push_back(resultado(s));
+        }
+    }
+
+    static ResultadoInstrucao resultado(const EstadoInstrucao& s) {
+        ResultadoInstrucao r = {s.posicao, s.issue.value_or(-1), s.exeCompleta.value_or(-1), s.write.value_or(-1), s.commit.value_or(-1), {}};
+        std::copy(s.instrucao.texto, s.instrucao.texto + 4, r.texto);
+        return r;
+    }
+
+    int issueNovaInstrucao(int largura) { // emite em ordem até largura instruções, parando na primeira que não encontra estação
+        int emitidas = 0;
+        while (emitidas < largura && emiteInstrucao()) emitidas++;
+        if (emitidas > 0) motivoEmissao = MotivoEmissao::Emitiu;
+        return emitidas;
+    }
+
+    bool emiteInstrucao() { //busca a nova instrução, procura uma unidade funcional para alocá-la e marca o ciclo de emissão da instrução
+        EstadoInstrucao* nova_instr_estado = getNovaInstrucao();
+        if (nova_instr_estado) {
+            const InstrucaoDecodificada& d = decodificada(*nova_instr_estado);
+            if (d.classe == ClasseUF::Nenhuma) {
+                std::cerr << "ERROR: Cannot determine FU type for " << programa->texto(d.texto[0]) << std::endl;
+                motivoEmissao = MotivoEmissao::OpcodeDesconhecido;
+                return false;
+            }
+
+            if (robCheio()) {
+                motivoEmissao = MotivoEmissao::RobCheio;
+                return false;
+            }
+            int idx = static_cast<int>(nova_instr_estado - estadoInstrucoes.data());
+            int s = d.memoria() ? getFUVaziaMem(d.classe) : getFUVaziaArithInt(d.classe);
+            if (s < 0) {
+                motivoEmissao = MotivoEmissao::EstacaoOcupada;
+                classeBloqueada = d.classe;
+                return false;
+            }
+            if (d.memoria()) {
+                alocaFuMem(s, idx);
+            } else {
+                alocaFU(s, idx);
+            }
+            if (compartilhados) compartilhados->estacoesLivres[static_cast<int>(d.classe)]--;
+            nova_instr_estado->issue = clock_cycle;
+            if (!rob.empty()) insereROB(idx, d.destino);
+            escreveEstacaoRegistrador(d, s);
+            proximaEmissao = -1;
+            emVoo++;
+            if (contadores) contadores->emitidas++;
+            if (eventos) eventos->registra({clock_cycle, nova_instr_estado->posicao, d.texto[0], static_cast<uint32_t>(s), TipoEvento::Emissao});
+            return true;
+        }
+        motivoEmissao = MotivoEmissao::SemInstrucao;
+        return false;
+    }
+
+    void executaInstrucao() { //verifica se a unidade funcional não tem dependências, decrementa o tempo restante de execução e marca o ciclo de término da instrução
+        if (estacoes.inicioEstagios < estacoes.numAritmeticas) despachaParaPipelines();
+        for (size_t s = estacoes.proximaOcupada(0); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) { // relê o conjunto a cada passo
+            if (estacoes.q1[s] != SEM_TAG || estacoes.q2[s] != SEM_TAG) continue;
+            if (aguardaPipeline(s)) continue;
+            int32_t& tempo = estacoes.tempo[s];
+            EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+            if (aguardaLSQ(s)) {
+                if (!liberaLoad(s)) continue;
+            }
+            if (cache && s >= estacoes.numAritmeticas && !instr.acessouCache && !acessaCache(s)) continue;
+            if (tempo > 0) {
+                tempo--;
+                instr.busy = true;
+            }
+            if (tempo == 0) {
+                instr.exeCompleta = clock_cycle;
+                instr.busy = false;
+                tempo = -1;
+                if (eventos) eventos->registra({clock_cycle, instr.posicao, instr.instrucao.texto[0], static_cast<uint32_t>(s), TipoEvento::FimExecucao});
+            }
+        }
+    }
+
+    int64_t escreveInstrucao(int cdbs) { //registra o resultado da instrução em seu registrador de destino, até cdbs escritas (-1: sem limite); retorna quantas
+        int64_t antes = escritas;
+        if (cdbs >= 0 || contadores) {
+            prontas.clear();
+            for (size_t s = estacoes.proximaOcupada(0); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+                if (prontaParaEscrever(s)) prontas.push_back(static_cast<uint32_t>(s));
+            }
+            size_t limite = cdbs >= 0 ? static_cast<size_t>(cdbs) : prontas.size();
+            if (prontas.size() > limite) {
+                if (contadores) {
+                    contadores->ciclosDisputaCDB++;
+                    contadores->esperaCDB += prontas.size() - limite;
+                }
+                // arbitragem por idade: os CDBs vão para as instruções mais antigas; as demais tentam de novo no próximo ciclo
+                auto maisAntiga = [this](uint32_t a, uint32_t b) {
+                    return estadoInstrucoes[estacoes.instrucao[a]].posicao < estadoInstrucoes[estacoes.instrucao[b]].posicao;
+                };
+                std::nth_element(prontas.begin(), prontas.begin() + limite, prontas.end(), maisAntiga);
+                prontas.resize(limite);
+                auto ordemEscrita = [this](uint32_t s) { // a mesma ordem do laço sem limite: buffers de memória e depois aritméticas
+                    return s >= estacoes.numAritmeticas ? s - estacoes.numAritmeticas : s + estacoes.size();
+                };
+                std::sort(prontas.begin(), prontas.end(), [&](uint32_t a, uint32_t b) { return ordemEscrita(a) < ordemEscrita(b); });
+                for (uint32_t s : prontas) escreveResultado(s);
+                return escritas - antes;
+            }
+        }
+        for (size_t s = estacoes.proximaOcupada(estacoes.numAritmeticas); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+            escreveResultado(s);
+        }
+        for (size_t s = estacoes.proximaOcupada(0); s < estacoes.numAritmeticas; s = estacoes.proximaOcupada(s + 1)) {
+            escreveResultado(s);
+        }
+        return escritas - antes;
+    }
+
+    void iniciaCiclo() { // avança o relógio e efetiva: o que vem antes da emissão no ciclo
+        clock_cycle++;
+        if (!rob.empty()) efetivaInstrucoes();
+    }
+
+    bool executa_ciclo() { //exxecuta um ciclo completo
+        iniciaCiclo();
+        issueNovaInstrucao(config.larguraEmissao);
+        executaInstrucao();
+        if (contadores) amostraCiclos(1);
+        int64_t escritasCiclo = escreveInstrucao(config.numCDBs > 0 ? config.numCDBs : -1);
+        if (contadores) contabilizaEscritas(escritasCiclo);
+        return verificaSeJaTerminou();
+    }
+
+    bool podeEmitir() { // true se a próxima instrução encontraria uma estação livre no próximo ciclo
+        EstadoInstrucao* proxima = getNovaInstrucao();
+        if (!proxima) return false;
+        const InstrucaoDecodificada& d = decodificada(*proxima);
+        if (d.classe == ClasseUF::Nenhuma || robCheio()) return false;
+        return (d.memoria() ? getFUVaziaMem(d.classe) : getFUVaziaArithInt(d.classe)) >= 0;
+    }
+
+    int ciclosOciosos() { // quantos ciclos seguintes apenas decrementam tempos; -1 se nada mais pode mudar (travamento)
+        if (podeEmitir()) return 0;
+        if (robOcupadas > 0 && estadoInstrucoes[rob[robInicio].vaga].write.has_value()) return 0; // efetivação no próximo ciclo
+        int ociosos = -1;
+        for (size_t s = estacoes.proximaOcupada(0); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+            if (estacoes.tempo[s] == -1) return 0; // escrita no próximo ciclo
+            if (estacoes.q1[s] != SEM_TAG || estacoes.q2[s] != SEM_TAG) continue; // só acorda com uma escrita
+            if (aguardaLSQ(s)) {
+                if (situacaoLoad(s) != SituacaoLoad::Espera) return 0;
+                continue; // a store que o segura só muda com uma escrita
+            }
+            if (cache && s >= estacoes.numAritmeticas && !estadoInstrucoes[estacoes.instrucao[s]].acessouCache) return 0; // acesso à cache no próximo ciclo
+            if (aguardaPipeline(s)) return 0; // disputa uma unidade no próximo ciclo
+            int ate = std::max(estacoes.tempo[s] - 1, 0);
+            if (ociosos < 0 || ate < ociosos) ociosos = ate;
+            if (ociosos == 0) return 0;
+        }
+        return ociosos;
+    }
+
+    void saltaCiclos(int n) { // aplica de uma vez o efeito de n ciclos ociosos (ver ciclosOciosos)
+        if (n <= 0) return;
+        if (contadores) { // nenhum ciclo pulado emite ou escreve: o motivo é o mesmo que impediu podeEmitir
+            EstadoInstrucao* proxima = getNovaInstrucao();
+            if (!proxima) {
+                motivoEmissao = MotivoEmissao::SemInstrucao;
+            } else if (decodificada(*proxima).classe == ClasseUF::Nenhuma) {
+                motivoEmissao = MotivoEmissao::OpcodeDesconhecido;
+            } else if (robCheio()) {
+                motivoEmissao = MotivoEmissao::RobCheio;
+            } else {
+                motivoEmissao = MotivoEmissao::EstacaoOcupada;
+                classeBloqueada = decodificada(*proxima).classe;
+            }
+            amostraCiclos(n);
+        }
+        clock_cycle += n;
+        for (size_t s = estacoes.proximaOcupada(0); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+            if (estacoes.q1[s] != SEM_TAG || estacoes.q2[s] != SEM_TAG) continue;
+            if (aguardaLSQ(s)) { // segue esperando as stores mais antigas
+                if (contadores) contadores->esperaOrdemMemoria += n;
+                continue;
+            }
+            if (aguardaPipeline(s)) continue;
+            if (estacoes.tempo[s] <= 0) continue;
+            estacoes.tempo[s] -= n;
+            estadoInstrucoes[estacoes.instrucao[s]].busy = true;
+        }
+    }
+
+    void escreveValores(std::ostream& out) const { // resultado da execução funcional: registradores e palavras de memória diferentes de zero
+        out << "\n== Valores Finais (execucao funcional) ==" << '\n' << "Registradores:";
+        for (uint32_t r : programa->ordemRegistradores) {
+            if (registradores.valor[r] == 0) continue;
+            out << ' ' << programa->nomes.nome(programa->nomeRegistrador[r]) << '=' << textoValor(registradores.valor[r], registradores.pontoFlutuante[r]);
+        }
+        out << '\n' << "Memoria (" << memoria.numPaginas() << " paginas):";
+        memoria.percorre([&](uint64_t endereco, uint64_t valor, bool pontoFlutuante) {
+            if (valor != 0) out << " [" << endereco << "]=" << textoValor(valor, pontoFlutuante);
+        });
+        out << '\n';
+    }
+
+    void printROB(std::ostream& out) const { // entradas do início (mais antiga) ao fim
+        out << "\n== Reorder Buffer (" << robOcupadas << "/" << rob.size() << ") ==" << '\n';
+        out << std::left << std::setw(9) << "Entrada"
+                  << std::setw(5) << "#"
+                  << std::setw(8) << "Instr"
+                  << std::setw(8) << "Destino"
+                  << std::setw(11) << "Estado"
+                  << "Desvio" << '\n';
+        for (size_t i = 0; i < robOcupadas; ++i) {
+            size_t entrada = (robInicio + i) % rob.size();
+            const EstadoInstrucao& s = estadoInstrucoes[rob[entrada].vaga];
+            const InstrucaoDecodificada& d = decodificada(s);
+            std::string desvio = "-";
+            if (d.flags & DESVIO) desvio = std::string(s.tomado ? "T" : "N") + " (previsto " + (s.previstoTomado ? "T" : "N") + ")";
+            out << std::left << std::setw(9) << entrada
+                      << std::setw(5) << s.posicao
+                      << std::setw(8) << programa->texto(d.texto[0])
+                      << std::setw(8) << (d.destino >= 0 ? programa->texto(d.texto[1]) : "-")
+                      << std::setw(11) << (s.write.has_value() ? "Escrita" : s.exeCompleta.has_value() ? "Executada" : "Emitida")
+                      << desvio << '\n';
+        }
+    }
+
+    std::string descreveRegistrador(uint32_t r, const char* livre) const { // nome da produtora, VAL(produtora) ou o texto pedido para registrador livre
+        switch (registradores.estado[r]) {
+            case EstadoRegistrador::Pendente: return estacoes.nome[registradores.tag[r]];
+            case EstadoRegistrador::Valor: return "VAL(" + estacoes.nome[registradores.tag[r]] + ")";
+            default: return livre;
+        }
+    }
+
+    void printEstadoDebug(std::ostream& out = std::cout) const { //imprime o estado das instruções, unidades funcionais, memória e registradores
+        out << "\n--- Clock: " << clock_cycle << " ---" << '\n';
+        out << "\n== Status das Instrucoes ==" << '\n';
+        out << std::left << std::setw(5) << "#"
+                  << std::setw(8) << "Instr"
+                  << std::setw(5) << "R"
+                  << std::setw(8) << "S"
+                  << std::setw(8) << "T"
+                  << std::setw(7) << "Issue"
+                  << std::setw(7) << "Exec"
+                  << std::setw(7) << "Write";
+        if (!rob.empty()) out << std::setw(8) << "Commit";
+        out << std::setw(6) << "Busy" << '\n';
+        std::vector<const EstadoInstrucao*> janela;
+        for (const auto& s : estadoInstrucoes) {
+            if (s.ativa) janela.push_back(&s);
+        }
+        std::sort(janela.begin(), janela.end(), [](const EstadoInstrucao* a, const EstadoInstrucao* b) { return a->posicao < b->posicao; });
+        for (const EstadoInstrucao* ps : janela) {
+            const EstadoInstrucao& s = *ps;
+            const InstrucaoDecodificada& d = decodificada(s);
+            out << std::left << std::setw(5) << s.posicao
+                      << std::setw(8) << programa->texto(d.texto[0])
+                      << std::setw(5) << programa->texto(d.texto[1])
+                      << std::setw(8) << programa->texto(d.texto[2])
+                      << std::setw(8) << programa->texto(d.texto[3])
+                      << std::setw(7) << (s.issue.has_value() ? std::to_string(s.issue.value()) : "-")
+                      << std::setw(7) << (s.exeCompleta.has_value() ? std::to_string(s.exeCompleta.value()) : "-")
+                      << std::setw(7) << (s.write.has_value() ? std::to_string(s.write.value()) : "-");
+            if (!rob.empty()) out << std::setw(8) << (s.commit.has_value() ? std::to_string(s.commit.value()) : "-");
+            out << std::setw(6) << (s.busy ? "Sim" : "Nao") << '\n';
+        }
+        if (!rob.empty()) printROB(out);
+
+        out << "\n== Estacoes de Reserva (Aritmeticas/Inteiro) ==" << '\n';
+        out << std::left << std::setw(10) << "Nome"
+                  << std::setw(8) << "Ocupado"
+                  << std::setw(7) << "Tempo"
+                  << std::setw(10) << "Op"
+                  << std::setw(12) << "Vj"
+                  << std::setw(12) << "Vk"
+                  << std::setw(10) << "Qj"
+                  << std::setw(10) << "Qk" << '\n';
+        for (size_t s = 0; s < estacoes.numAritmeticas; ++s) {
+            out << std::left << std::setw(10) << estacoes.nome[s]
+                      << std::setw(8) << (estacoes.ocupado[s] ? "Sim" : "Nao")
+                      << std::setw(7) << textoTempo(s)
+                      << std::setw(10) << textoOperacao(s)
+                      << std::setw(12) << textoOperando(estacoes.v1Tipo[s], estacoes.v1[s])
+                      << std::setw(12) << textoOperando(estacoes.v2Tipo[s], estacoes.v2[s])
+                      << std::setw(10) << textoTag(estacoes.q1[s])
+                      << std::setw(10) << textoTag(estacoes.q2[s]) << '\n';
+        }
+
+        out << "\n== Buffers de Load/Store (Memoria) ==" << '\n';
+        out << std::left << std::setw(10) << "Nome"
+                  << std::setw(8) << "Ocupado"
+                  << std::setw(7) << "Tempo"
+                  << std::setw(8) << "Op"
+                  << std::setw(15) << "Endereco"
+                  << std::setw(10) << "Dest/Src"
+                  << std::setw(10) << "Qi"
+                  << std::setw(10) << "Qj (Base)" << '\n';
+        for (size_t s = estacoes.numAritmeticas; s < estacoes.size(); ++s) {
+            const InstrucaoDecodificada* d = estacoes.instrucao[s] >= 0 ? &decodificada(estadoInstrucoes[estacoes.instrucao[s]]) : nullptr;
+            out << std::left << std::setw(10) << estacoes.nome[s]
+                      << std::setw(8) << (estacoes.ocupado[s] ? "Sim" : "Nao")
+                      << std::setw(7) << textoTempo(s)
+                      << std::setw(8) << textoOperacao(s)
+                      << std::setw(15) << (d ? programa->texto(d->texto[2]) + "+" + programa->texto(d->texto[3]) : "-")
+                      << std::setw(10) << (d ? programa->texto(d->texto[1]) : "-")
+                      << std::setw(10) << textoTag(estacoes.q1[s])
+                      << std::setw(10) << textoTag(estacoes.q2[s]) << '\n';
+        }
+
+        out << "\n== Status dos Registradores ==" << '\n';
+        bool first_reg = true;
+        for (uint32_t r : programa->ordemRegistradores) {
+            if (!registradores.visivel[r]) continue;
+            if (!first_reg) out << ", ";
+            out << programa->nomes.nome(programa->nomeRegistrador[r]) << ":" << descreveRegistrador(r, "null");
+            first_reg = false;
+        }
+        out << "\n-----------------------------------------" << '\n';
+    }
+
+private:
+    std::unique_ptr<FonteInstrucoes> fonte;
+    std::vector<int32_t> vagasLivres; // vagas da janela (só com fonte)
+    int32_t proximaEmissao = -1;      // vaga da próxima instrução a emitir, -1 se ainda não buscada
+    size_t proximaRetida = 0;         // sem fonte: índice da próxima instrução a emitir
+    int64_t buscadas = 0;
+    int64_t emVoo = 0;                // emitidas e ainda não escritas
+    int64_t concluidas = 0;
+    int64_t escritas = 0;             // resultados escritos no CDB (com ROB, antes da efetivação)
+    int latencias[NUM_CLASSES_UF];
+    MotivoEmissao motivoEmissao = MotivoEmissao::SemInstrucao; // resultado da última tentativa de emissão
+    ClasseUF classeBloqueada = ClasseUF::Nenhuma;
+    std::vector<uint32_t> prontas; // estações disputando os CDBs no ciclo
+    bool fonteEsgotada = false;
+
+    struct EntradaROB { // instrução emitida, em ordem de programa, e o mapeamento do seu destino antes dela
+        int32_t vaga = -1;
+        int32_t destino = -1;
+        EstadoRegistrador estadoAnterior = EstadoRegistrador::Livre;
+        uint32_t tagAnterior = SEM_TAG;
+        uint8_t visivelAnterior = 0;
+        uint32_t geracaoAnterior = 0;
+
+        void serializa(ArquivoEstado& a) {
+            a.campo(vaga);
+            a.campo(destino);
+            a.campo(estadoAnterior);
+            a.campo(tagAnterior);
+            a.campo(visivelAnterior);
+            a.campo(geracaoAnterior);
+        }
+    };
+    std::vector<EntradaROB> rob; // circular; vazio sem ROB_SIZE
+    size_t robInicio = 0;
+    size_t robOcupadas = 0;
+    int64_t pcBusca = 0;         // índice no programa da próxima instrução a buscar
+    std::unique_ptr<PreditorDesvios> preditor; // só com ROB
+    std::unique_ptr<HierarquiaMemoria> cache;  // L1D_SIZE com FUNCTIONAL 1
+
+    struct PipelinesClasse { // PIPES de uma classe
+        std::vector<int64_t> ultimaEntrada; // por unidade: ciclo em que aceitou a última instrução; vazio = classe sem PIPES
+        int intervalo = 1;
+    };
+    PipelinesClasse pipelines[NUM_CLASSES_UF];
+    std::vector<uint32_t> candidatas; // estações prontas disputando as unidades no ciclo
+    int32_t desvioErrado = -1;   // FUNCTIONAL: vaga do desvio mal previsto do caminho certo; até a recuperação, a busca segue o caminho errado
+    uint64_t historico = 0;      // histórico global especulativo: atualizado na previsão, refeito na recuperação
+    std::unordered_map<int64_t, uint32_t> execucoesDesvio; // pc do desvio com padrão -> vezes buscado no caminho atual
+
+    void criaJanela() { // cada instrução em voo ocupa uma estação (ou, com ROB, uma entrada do ROB), mais a próxima a emitir
+        estadoInstrucoes.assign((rob.empty() ? estacoes.size() : rob.size()) + 1, EstadoInstrucao());
+        vagasLivres.clear();
+        for (size_t i = estadoInstrucoes.size(); i-- > 0;) vagasLivres.push_back(static_cast<int32_t>(i));
+    }
+
+    void buscaInstrucao() {
+        if (!fonte) {
+            if (proximaRetida < estadoInstrucoes.size()) {
+                proximaEmissao = static_cast<int32_t>(proximaRetida++);
+                if (config.funcional) executaFuncional(estadoInstrucoes[proximaEmissao]);
+            } else {
+                fonteEsgotada = true;
+            }
+            return;
+        }
+        if (fonteEsgotada || vagasLivres.empty()) return;
+        int32_t vaga = vagasLivres.back();
+        InstrucaoDecodificada d;
+        if (!fonte->proxima(d)) {
+            fonteEsgotada = true;
+            return;
+        }
+        vagasLivres.pop_back();
+        estadoInstrucoes[vaga] = EstadoInstrucao(d, buscadas++);
+        estadoInstrucoes[vaga].pc = pcBusca++;
+        atualizaRegistradores();
+        bool caminhoErrado = desvioErrado >= 0;
+        if (config.funcional && !caminhoErrado) executaFuncional(estadoInstrucoes[vaga]);
+        if (!rob.empty() && (d.flags & DESVIO)) {
+            preveDesvio(estadoInstrucoes[vaga]);
+            if (config.funcional && caminhoErrado) { // fora do caminho certo não há valores: o desvio segue a previsão
+                estadoInstrucoes[vaga].tomado = estadoInstrucoes[vaga].previstoTomado;
+            } else if (config.funcional && estadoInstrucoes[vaga].tomado != estadoInstrucoes[vaga].previstoTomado) {
+                desvioErrado = vaga;
+            }
+        }
+        proximaEmissao = vaga;
+    }
+
+    // modelo funcional: executa cada instrução na busca, em ordem de programa e só no caminho certo, fornecendo
+    // ao modelo de tempo os resultados reais dos desvios e os endereços de LD/SD
+    void executaFuncional(EstadoInstrucao& instr) {
+        const InstrucaoDecodificada& d = instr.instrucao;
+        switch (d.op) {
+            case Opcode::ADDD: escreveDouble(d.destino, comoDouble(d.fonteJ) + comoDouble(d.fonteK)); break;
+            case Opcode::SUBD: escreveDouble(d.destino, comoDouble(d.fonteJ) - comoDouble(d.fonteK)); break;
+            case Opcode::MULTD: escreveDouble(d.destino, comoDouble(d.fonteJ) * comoDouble(d.fonteK)); break;
+            case Opcode::DIVD: escreveDouble(d.destino, comoDouble(d.fonteJ) / comoDouble(d.fonteK)); break;
+            case Opcode::ADD: escreveInteiro(d.destino, comoInteiro(d.fonteJ) + comoInteiro(d.fonteK)); break;
+            case Opcode::DADDUI: escreveInteiro(d.destino, comoInteiro(d.fonteJ) + static_cast<uint64_t>(d.imediato)); break;
+            case Opcode::LD:
+                instr.endereco = comoInteiro(d.fonteK) + static_cast<uint64_t>(d.imediato);
+                instr.enderecoReal = true;
+                defineValor(d.destino, memoria.le(instr.endereco)); // cópia dos bits, como o SD
+                break;
+            case Opcode::SD:
+                instr.endereco = comoInteiro(d.fonteK) + static_cast<uint64_t>(d.imediato);
+                instr.enderecoReal = true;
+                memoria.escreve(instr.endereco, bits(d.fonteJ), d.fonteJ.registrador >= 0 ? registradores.pontoFlutuante[d.fonteJ.registrador] != 0
+                                                                                           : literalPontoFlutuante(programa->texto(d.fonteJ.nome)));
+                break;
+            case Opcode::BEQ: instr.tomado = bits(d.fonteJ) == bits(d.fonteK); break;
+            case Opcode::BNEZ: instr.tomado = bits(d.fonteJ) != 0; break;
+            default: break;
+        }
+    }
+
+    uint64_t bits(const OperandoDecodificado& o) const { // literal: lido como inteiro
+        if (o.registrador >= 0) return registradores.valor[o.registrador];
+        return o.nome == SEM_ID ? 0 : valorLiteral(programa->texto(o.nome), false);
+    }
+
+    double comoDouble(const OperandoDecodificado& o) const {
+        if (o.registrador < 0) return o.nome == SEM_ID ? 0.0 : std::strtod(programa->texto(o.nome).c_str(), nullptr);
+        uint64_t v = registradores.valor[o.registrador];
+        return registradores.pontoFlutuante[o.registrador] ? doubleDosBits(v) : static_cast<double>(static_cast<int64_t>(v));
+    }
+
+    uint64_t comoInteiro(const OperandoDecodificado& o) const {
+        if (o.registrador >= 0 && registradores.pontoFlutuante[o.registrador]) return inteiroDoDouble(doubleDosBits(registradores.valor[o.registrador]));
+        return bits(o);
+    }
+
+    void defineValor(int32_t r, uint64_t v) {
+        if (r >= 0 && !registradores.zero[r]) registradores.valor[r] = v;
+    }
+
+    void escreveDouble(int32_t r, double v) {
+        if (r >= 0) defineValor(r, registradores.pontoFlutuante[r] ? bitsDouble(v) : inteiroDoDouble(v));
+    }
+
+    void escreveInteiro(int32_t r, uint64_t v) {
+        if (r >= 0) defineValor(r, registradores.pontoFlutuante[r] ? bitsDouble(static_cast<double>(static_cast<int64_t>(v))) : v);
+    }
+
+    void atualizaRegistradores() { // a fonte pode ter criado registradores novos ao decodificar
+        size_t total = programa->nomeRegistrador.size();
+        for (size_t r = registradores.size(); r < total; ++r) {
+            registradores.estado.push_back(EstadoRegistrador::Livre);
+            registradores.tag.push_back(SEM_TAG);
+            registradores.visivel.push_back(programa->registradorInicial[r]);
+            const std::string& nome = programa->nomes.nome(programa->nomeRegistrador[r]);
+            auto inicial = config.dados.registradores.find(nome);
+            registradores.valor.push_back(inicial != config.dados.registradores.end() ? inicial->second : 0);
+            registradores.pontoFlutuante.push_back(ehRegistradorPF(nome));
+            registradores.zero.push_back(nome == "R0");
+            registradores.geracao.push_back(0);
+        }
+    }
+
+    void amostraCiclos(int64_t n) { // soma n ciclos com o estado atual das estações nos contadores
+        Contadores& c = *contadores;
+        c.ciclos += n;
+        c.ciclosPorMotivo[static_cast<int>(motivoEmissao)] += n;
+        if (motivoEmissao == MotivoEmissao::EstacaoOcupada) c.bloqueiosPorClasse[static_cast<int>(classeBloqueada)] += n;
+        for (size_t s = estacoes.proximaOcupada(0); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+            if (estacoes.estagio(s)) continue; // estações, sem os estágios de PIPES
+            c.ocupacaoPorClasse[static_cast<int>(estacoes.classe[s])] += n;
+            if (estacoes.q1[s] != SEM_TAG || estacoes.q2[s] != SEM_TAG) c.esperaOperandos += n;
+        }
+    }
+
+    void contabilizaEscritas(int64_t n) {
+        contadores->escritas += n;
+        if (n > 0) contadores->ciclosComEscrita++;
+        contadores->maximoEscritasCiclo = std::max(contadores->maximoEscritasCiclo, n);
+    }
+
+    void aposentaInstrucao(int32_t vaga) { // entrega a instrução escrita ao destino e, com fonte, libera a vaga
+        EstadoInstrucao& instr = estadoInstrucoes[vaga];
+        emVoo--;
+        concluidas++;
+        if (!destinosResultados.empty()) {
+            ResultadoInstrucao r = resultado(instr);
+            for (DestinoResultados* destino : destinosResultados) destino->registra(r);
+        }
+        if (fonte) {
+            instr.ativa = false;
+            vagasLivres.push_back(vaga);
+        }
+    }
+
+    void criaEstacoes(const std::map<std::string, int>& unidades) { // cria as estações na ordem alfabética dos nomes
+        std::vector<std::pair<std::string, std::string>> criadas;
+        for (const auto& pair : unidades) {
+            for (int i = 0; i < pair.second; ++i) {
+                criadas.emplace_back(pair.first + std::to_string(i + 1), pair.first);
+            }
+        }
+        std::sort(criadas.begin(), criadas.end());
+        for (const auto& c : criadas) {
+            estacoes.adiciona(c.first, classePorNome(c.second));
+        }
+    }
+
+    void criaEstagios() { // PIPES: estágios para as instruções em execução, o bastante para cada unidade aceitar uma a cada II ciclos enquanto a mais antiga escreve
+        for (const auto& pair : config.pipelines) {
+            int c = static_cast<int>(classePorNome(pair.first));
+            PipelinesClasse& p = pipelines[c];
+            p.ultimaEntrada.assign(pair.second.quantidade, INT64_MIN / 2);
+            p.intervalo = pair.second.intervalo;
+            int porUnidade = (std::max(latencias[c], 1) + p.intervalo - 1) / p.intervalo + 2;
+            for (int i = 0; i < pair.second.quantidade * porUnidade; ++i) {
+                estacoes.adiciona(pair.first + "Pipe" + std::to_string(i + 1), static_cast<ClasseUF>(c));
+            }
+        }
+    }
+
+    void preparaOperando(const OperandoDecodificado& fonte, TipoOperando& vTipo, uint32_t& v, uint32_t& q) const {
+        vTipo = TipoOperando::Literal;
+        if (fonte.nome == SEM_ID) {
+            v = programa->idNaoAplicavel;
+            return;
+        }
+        v = fonte.nome;
+        if (fonte.registrador < 0) return;
+        switch (registradores.estado[fonte.registrador]) {
+            case EstadoRegistrador::Valor:
+                vTipo = TipoOperando::Valor;
+                v = registradores.tag[fonte.registrador];
+                break;
+            case EstadoRegistrador::Pendente:
+                vTipo = TipoOperando::Vazio;
+                q = registradores.tag[fonte.registrador];
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint32_t produtora(int32_t r) const { // tag da estação que ainda vai escrever em r
+        if (r >= 0 && registradores.estado[r] == EstadoRegistrador::Pendente) return registradores.tag[r];
+        return SEM_TAG;
+    }
+
+    bool prontaParaEscrever(size_t s) const { // execução terminada num ciclo anterior e resultado ainda não escrito
+        if (!estacoes.ocupado[s] || estacoes.tempo[s] != -1 || estacoes.instrucao[s] < 0) return false;
+        const EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+        if (static_cast<ModoLSQ>(config.modoLSQ) == ModoLSQ::Especulativo && estacoes.classe[s] == ClasseUF::Load && storeSemEndereco(s)) {
+            return false; // o load especulativo só escreve quando nenhuma store mais antiga pode invalidá-lo
+        }
+        return !instr.write.has_value() && instr.exeCompleta.has_value() && instr.exeCompleta.value() < clock_cycle;
+    }
+
+    // PIPES: a estação só guarda a instrução até ela entrar numa unidade de execução; a partir daí ela segue num
+    // estágio, que passa a ser a sua tag, e a estação fica livre para a emissão
+
+    bool aguardaPipeline(size_t s) const { // instrução numa estação de classe com PIPES: só executa depois de despachada
+        return s < estacoes.inicioEstagios && !pipelines[static_cast<int>(estacoes.classe[s])].ultimaEntrada.empty();
+    }
+
+    void despachaParaPipelines() { // por classe, as estações prontas mais antigas entram nas unidades livres
+        for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+            PipelinesClasse& p = pipelines[c];
+            if (p.ultimaEntrada.empty()) continue;
+            candidatas.clear();
+            for (size_t s = estacoes.proximaOcupada(0); s < estacoes.inicioEstagios; s = estacoes.proximaOcupada(s + 1)) {
+                if (static_cast<int>(estacoes.classe[s]) == c && estacoes.q1[s] == SEM_TAG && estacoes.q2[s] == SEM_TAG) {
+                    candidatas.push_back(static_cast<uint32_t>(s));
+                }
+            }
+            std::sort(candidatas.begin(), candidatas.end(), [this](uint32_t a, uint32_t b) {
+                return estadoInstrucoes[estacoes.instrucao[a]].posicao < estadoInstrucoes[estacoes.instrucao[b]].posicao;
+            });
+            size_t despachadas = 0;
+            size_t estagio = estacoes.inicioEstagios;
+            for (int64_t& entrada : compartilhados ? compartilhados->ultimaEntrada[c] : p.ultimaEntrada) {
+                if (despachadas == candidatas.size()) break;
+                if (clock_cycle - entrada < p.intervalo) continue;
+                while (estagio < estacoes.numAritmeticas && (static_cast<int>(estacoes.classe[estagio]) != c || estacoes.ocupado[estagio])) estagio++;
+                if (estagio == estacoes.numAritmeticas) break; // estágios cheios de resultados à espera do CDB
+                entrada = clock_cycle;
+                moveParaEstagio(candidatas[despachadas++], estagio);
+            }
+            if (contadores) contadores->esperaPipeline[c] += candidatas.size() - despachadas;
+        }
+    }
+
+    void moveParaEstagio(size_t s, size_t e) { // a tag da instrução passa de s para e: registrador de destino, consumidoras e ROB
+        estacoes.instrucao[e] = estacoes.instrucao[s];
+        estacoes.tempo[e] = estacoes.tempo[s];
+        estacoes.marca(e, true);
+        estacoes.v1Tipo[e] = estacoes.v1Tipo[s];
+        estacoes.v2Tipo[e] = estacoes.v2Tipo[s];
+        estacoes.v1[e] = estacoes.v1[s];
+        estacoes.v2[e] = estacoes.v2[s];
+        const EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+        int32_t r = instr.instrucao.destino;
+        if (r >= 0 && registradores.estado[r] == EstadoRegistrador::Pendente && registradores.tag[r] == s) registradores.tag[r] = static_cast<uint32_t>(e);
+        for (int32_t vaga = estacoes.primeiraEspera[s]; vaga >= 0; vaga = estacoes.proximaEspera[vaga]) {
+            size_t consumidora = static_cast<size_t>(vaga) / 2;
+            (vaga % 2 == 0 ? estacoes.q1[consumidora] : estacoes.q2[consumidora]) = static_cast<uint32_t>(e);
+        }
+        estacoes.primeiraEspera[e] = estacoes.primeiraEspera[s];
+        estacoes.primeiraEspera[s] = -1;
+        for (size_t i = 0; i < robOcupadas; ++i) {
+            EntradaROB& entrada = rob[(robInicio + i) % rob.size()];
+            if (entrada.estadoAnterior == EstadoRegistrador::Pendente && entrada.tagAnterior == s) entrada.tagAnterior = static_cast<uint32_t>(e);
+        }
+        if (eventos) eventos->registra({clock_cycle, instr.posicao, instr.instrucao.texto[0], static_cast<uint32_t>(e), TipoEvento::Despacho});
+        desalocaUF(s);
+    }
+
+    // LSQ: os buffers de Load e Store fazem o papel da fila; a idade vem da posição de busca e o endereço de uma
+    // store é conhecido assim que sua base (Qj) está pronta
+
+    bool aguardaLSQ(size_t s) const { // load ainda não liberado pela fila de memória
+        return config.modoLSQ && estacoes.classe[s] == ClasseUF::Load && !estadoInstrucoes[estacoes.instrucao[s]].iniciouMemoria;
+    }
+
+    static bool mesmoEndereco(const EstadoInstrucao& a, const EstadoInstrucao& b) { // palavras de 8 bytes
+        return a.baseEndereco == b.baseEndereco && (a.endereco >> 3) == (b.endereco >> 3);
+    }
+
+    enum class SituacaoLoad : uint8_t { Memoria, Encaminha, Espera };
+
+    SituacaoLoad situacaoLoad(size_t s, int64_t* posicaoFonte = nullptr) const { // de onde o load pode ler agora
+        const EstadoInstrucao& load = estadoInstrucoes[estacoes.instrucao[s]];
+        ModoLSQ modo = static_cast<ModoLSQ>(config.modoLSQ);
+        int32_t fonte = -1;
+        int64_t posicao = -1;
+        for (size_t t = estacoes.proximaOcupada(estacoes.numAritmeticas); t < estacoes.size(); t = estacoes.proximaOcupada(t + 1)) {
+            if (estacoes.classe[t] != ClasseUF::Store) continue;
+            const EstadoInstrucao& store = estadoInstrucoes[estacoes.instrucao[t]];
+            if (store.posicao > load.posicao) continue;
+            if (estacoes.q2[t] != SEM_TAG && modo != ModoLSQ::Perfeito) { // endereço ainda desconhecido
+                if (modo == ModoLSQ::Conservador) return SituacaoLoad::Espera;
+                continue;
+            }
+            if (mesmoEndereco(store, load) && store.posicao > posicao) {
+                fonte = static_cast<int32_t>(t);
+                posicao = store.posicao;
+            }
+        }
+        if (posicaoFonte) *posicaoFonte = posicao;
+        if (fonte < 0) return SituacaoLoad::Memoria;
+        bool pronta = estacoes.q1[fonte] == SEM_TAG && estacoes.q2[fonte] == SEM_TAG; // dado e endereço da store (o oráculo do perfeito não adianta o dado)
+        return pronta ? SituacaoLoad::Encaminha : SituacaoLoad::Espera;
+    }
+
+    bool liberaLoad(size_t s) { // tenta liberar o load na fila; com encaminhamento, o dado chega da store em um ciclo
+        int64_t posicaoFonte = -1;
+        SituacaoLoad situacao = situacaoLoad(s, &posicaoFonte);
+        if (situacao == SituacaoLoad::Espera) {
+            if (contadores) contadores->esperaOrdemMemoria++;
+            return false;
+        }
+        EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+        instr.iniciouMemoria = true;
+        instr.posicaoFonte = situacao == SituacaoLoad::Encaminha ? posicaoFonte : -1;
+        if (situacao == SituacaoLoad::Encaminha) {
+            estacoes.tempo[s] = std::min(estacoes.tempo[s], 1);
+            if (contadores) contadores->encaminhamentos++;
+        }
+        return true;
+    }
+
+    bool storeSemEndereco(size_t s) const { // alguma store mais antiga que o load em s ainda não tem endereço
+        int64_t posicao = estadoInstrucoes[estacoes.instrucao[s]].posicao;
+        for (size_t t = estacoes.proximaOcupada(estacoes.numAritmeticas); t < estacoes.size(); t = estacoes.proximaOcupada(t + 1)) {
+            if (estacoes.classe[t] == ClasseUF::Store && estacoes.q2[t] != SEM_TAG &&
+                estadoInstrucoes[estacoes.instrucao[t]].posicao < posicao) return true;
+        }
+        return false;
+    }
+
+    bool acessaCache(size_t s) { // soma ao tempo da estação a latência de falta; false se a falta espera um MSHR
+        EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+        if (instr.posicaoFonte >= 0 || !instr.enderecoReal) { // dado encaminhado pelo LSQ, ou caminho errado sem endereço: conta como acerto
+            instr.acessouCache = true;
+            return true;
+        }
+        int extra = cache->acessa(instr.endereco, estacoes.classe[s] == ClasseUF::Store, clock_cycle, contadores);
+        if (extra < 0) {
+            if (contadores) contadores->esperaMSHR++;
+            return false;
+        }
+        estacoes.tempo[s] += extra;
+        instr.acessouCache = true;
+        return true;
+    }
+
+    void verificaViolacoes(size_t t) { // loads mais novos que passaram pela store em t e leem o mesmo endereço são reexecutados
+        const EstadoInstrucao& store = estadoInstrucoes[estacoes.instrucao[t]];
+        for (size_t s = estacoes.proximaOcupada(estacoes.numAritmeticas); s < estacoes.size(); s = estacoes.proximaOcupada(s + 1)) {
+            if (estacoes.classe[s] != ClasseUF::Load) continue;
+            EstadoInstrucao& load = estadoInstrucoes[estacoes.instrucao[s]];
+            if (!load.iniciouMemoria || load.posicao < store.posicao || load.posicaoFonte > store.posicao || !mesmoEndereco(store, load)) continue;
+            load.iniciouMemoria = false;
+            load.acessouCache = false;
+            load.exeCompleta.reset();
+            load.busy = false;
+            estacoes.tempo[s] = latencias[static_cast<int>(ClasseUF::Load)];
+            if (contadores) contadores->reexecucoes++;
+        }
+    }
+
+    void escreveResultado(size_t s) {
+        if (!prontaParaEscrever(s)) return;
+        EstadoInstrucao& instr = estadoInstrucoes[estacoes.instrucao[s]];
+
+        instr.write = clock_cycle;
+        escritas++;
+        int32_t r = decodificada(instr).destino;
+        if (r >= 0 && registradores.estado[r] == EstadoRegistrador::Pendente && registradores.tag[r] == s) {
+            registradores.estado[r] = EstadoRegistrador::Valor;
+        }
+        liberaUFEsperandoResultado(static_cast<uint32_t>(s));
+        if (eventos) eventos->registra({clock_cycle, instr.posicao, instr.instrucao.texto[0], static_cast<uint32_t>(s), TipoEvento::Escrita});
+        int32_t vaga = estacoes.instrucao[s];
+        desalocaUF(s);
+        if (rob.empty()) {
+            aposentaInstrucao(vaga);
+            return;
+        }
+        // com ROB, a instrução espera a efetivação; os mapeamentos guardados que apontavam para s passam a ter o valor
+        for (size_t i = 0; i < robOcupadas; ++i) {
+            EntradaROB& e = rob[(robInicio + i) % rob.size()];
+            if (e.estadoAnterior == EstadoRegistrador::Pendente && e.tagAnterior == s) e.estadoAnterior = EstadoRegistrador::Valor;
+        }
+        if ((instr.instrucao.flags & DESVIO) && instr.tomado != instr.previstoTomado) recuperaDesvio(vaga);
+    }
+
+    bool robCheio() const { return !rob.empty() && robOcupadas == rob.size(); }
+
+    void insereROB(int32_t vaga, int32_t destino) { // guarda o mapeamento de destino anterior para desfazê-lo num descarte
+        EntradaROB& e = rob[(robInicio + robOcupadas) % rob.size()];
+        e.vaga = vaga;
+        e.destino = destino;
+        if (destino >= 0) {
+            e.estadoAnterior = registradores.estado[destino];
+            e.tagAnterior = registradores.tag[destino];
+            e.visivelAnterior = registradores.visivel[destino];
+            e.geracaoAnterior = registradores.geracao[destino];
+        }
+        robOcupadas++;
+    }
+
+    void efetivaInstrucoes() { // commit em ordem de até COMMIT_WIDTH instruções do início do ROB já escritas
+        for (int n = 0; n < config.larguraCommit && robOcupadas > 0; ++n) {
+            int32_t vaga = rob[robInicio].vaga;
+            EstadoInstrucao& instr = estadoInstrucoes[vaga];
+            if (!instr.write.has_value()) break;
+            instr.commit = clock_cycle;
+            if (instr.instrucao.flags & DESVIO) efetivaDesvio(instr);
+            robInicio = (robInicio + 1) % rob.size();
+            robOcupadas--;
+            aposentaInstrucao(vaga);
+        }
+    }
+
+    void preveDesvio(EstadoInstrucao& instr) { // a previsão decide o caminho buscado
+        const InstrucaoDecodificada& d = instr.instrucao;
+        aplicaPadrao(instr);
+        instr.historico = historico;
+        instr.previstoTomado = preditor->preve(instr.pc, historico);
+        historico = (historico << 1) | instr.previstoTomado;
+        if (instr.previstoTomado) redirecionaBusca(programa->alvo(d, instr.pc));
+    }
+
+    void aplicaPadrao(EstadoInstrucao& instr) { // sem FUNCTIONAL, resultado real pelo padrão do desvio
+        const InstrucaoDecodificada& d = instr.instrucao;
+        if (!seguePadrao(d)) return; // só estes consultam a contagem: traces longos sem padrão não fazem a tabela crescer
+        uint32_t n = execucoesDesvio[instr.pc]++;
+        const std::string& padrao = programa->nomes.nome(d.padrao);
+        char c = padrao.empty() ? 'N' : padrao[n % padrao.size()];
+        instr.tomado = c == 'T' || c == 't';
+    }
+
+    bool seguePadrao(const InstrucaoDecodificada& d) const {
+        return d.padrao != SEM_ID && !config.funcional;
+    }
+
+    void redirecionaBusca(int64_t pc) {
+        pcBusca = pc;
+        fonte->posiciona(pc);
+        fonteEsgotada = false;
+    }
+
+    void efetivaDesvio(const EstadoInstrucao& instr) { // treina o preditor só com desvios do caminho certo
+        preditor->atualiza(instr.pc, instr.historico, instr.tomado);
+        if (!contadores) return;
+        EstatisticaDesvio& e = contadores->porDesvio[instr.pc];
+        e.op = instr.instrucao.texto[0];
+        e.rotulo = instr.instrucao.rotulo;
+        e.execucoes++;
+        contadores->desvios++;
+        if (instr.tomado != instr.previstoTomado) {
+            int64_t penalidade = instr.write.value() - instr.issue.value();
+            e.erros++;
+            e.ciclosPenalidade += penalidade;
+            contadores->errosPrevisao++;
+            contadores->ciclosPenalidade += penalidade;
+        }
+    }
+
+    void recuperaDesvio(int32_t vagaDesvio) { // descarta as instruções mais novas que o desvio e retoma a busca no caminho certo
+        if (proximaEmissao >= 0) {
+            descarta(proximaEmissao);
+            proximaEmissao = -1;
+        }
+        while (robOcupadas > 0) {
+            EntradaROB& e = rob[(robInicio + robOcupadas - 1) % rob.size()];
+            if (e.vaga == vagaDesvio) break;
+            if (e.destino >= 0) { // do mais novo para o mais antigo: no fim fica o mapeamento anterior ao desvio
+                registradores.estado[e.destino] = e.estadoAnterior;
+                registradores.tag[e.destino] = e.tagAnterior;
+                registradores.visivel[e.destino] = e.visivelAnterior;
+                registradores.geracao[e.destino] = e.geracaoAnterior;
+            }
+            if (!estadoInstrucoes[e.vaga].write.has_value()) {
+                for (size_t s = 0; s < estacoes.size(); ++s) {
+                    if (estacoes.ocupado[s] && estacoes.instrucao[s] == e.vaga) desalocaUF(s);
+                }
+            }
+            descarta(e.vaga);
+            robOcupadas--;
+        }
+        estacoes.refazEsperas();
+        const EstadoInstrucao& desvio = estadoInstrucoes[vagaDesvio];
+        buscadas = desvio.posicao + 1;
+        historico = (desvio.historico << 1) | desvio.tomado;
+        if (vagaDesvio == desvioErrado) desvioErrado = -1;
+        redirecionaBusca(desvio.tomado ? programa->alvo(desvio.instrucao, desvio.pc) : desvio.pc + 1);
+    }
+
+    void descarta(int32_t vaga) { // devolve a vaga de uma instrução do caminho errado
+        EstadoInstrucao& instr = estadoInstrucoes[vaga];
+        if ((instr.instrucao.flags & DESVIO) && seguePadrao(instr.instrucao)) execucoesDesvio[instr.pc]--;
+        if (instr.issue.has_value()) emVoo--;
+        instr.ativa = false;
+        vagasLivres.push_back(vaga);
+        if (contadores) contadores->descartadas++;
+    }
+
+    std::string textoTempo(size_t s) const {
+        return estacoes.tempo[s] == SEM_TEMPO ? "-" : std::to_string(estacoes.tempo[s]);
+    }
+
+    std::string textoOperacao(size_t s) const {
+        return estacoes.instrucao[s] >= 0 ? programa->texto(decodificada(estadoInstrucoes[estacoes.instrucao[s]]).texto[0]) : "-";
+    }
+
+    std::string textoOperando(TipoOperando tipo, uint32_t v) const {
+        switch (tipo) {
+            case TipoOperando::Literal: return programa->nomes.nome(v);
+            case TipoOperando::Valor: return "VAL(" + estacoes.nome[v] + ")";
+            default: return "-";
+        }
+    }
+
+    std::string textoTag(uint32_t q) const {
+        return q == SEM_TAG ? "-" : estacoes.nome[q];
+    }
+};
+
+std::string trim(const std::string& str) {
+    const std::string whitespace = " \t\n\r\f\v";
+    size_t start = str.find_first_not_of(whitespace);
+    if (start == std::string::npos)
+        return "";
+    size_t end = str.find_last_not_of(whitespace);
+    return str.substr(start, end - start + 1);
+}
+
+class LeitorTrace { // lê o arquivo de entrada: a configuração na abertura e as instruções uma a uma, sob demanda
+public:
+    bool abre(const std::string& filename, ConfigSimulador& out_config) { // lê o arquivo até o início do bloco de instruções
+        infile.open(filename);
+        if (!infile.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        config = &out_config;
+        InstrucaoInput ignorada;
+        while (currentState != ParseState::INSTRUCTIONS && leLinha(ignorada)) {}
+        return true;
+    }
+
+    bool proxima(InstrucaoInput& out) { // false ao chegar em INSTRUCTIONS_END ou ao fim do arquivo
+        out = InstrucaoInput();
+        while (leLinha(out)) {
+            if (!out.d_operacao.empty()) return true;
+        }
+        return false;
+    }
+
+    const std::string& rotuloNoFim() const { return rotuloPendente; } // depois da última instrução: um alvo válido, o fim do programa
+
+private:
+    enum class ParseState { NONE, CONFIG, DATA, INSTRUCTIONS, END };
+    std::ifstream infile;
+    ConfigSimulador* config = nullptr;
+    ParseState currentState = ParseState::NONE;
+    std::string rotuloPendente;
+
+    bool leLinha(InstrucaoInput& instr) { // processa uma linha; false se não há mais linhas a ler
+        std::string line;
+        if (currentState == ParseState::END || !std::getline(infile, line)) {
+            currentState = ParseState::END;
+            return false;
+        }
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            return true;
+        }
+
+        if (line == "CONFIG_BEGIN") {
+            currentState = ParseState::CONFIG;
+            return true;
+        } else if (line == "CONFIG_END" || line == "DATA_END") {
+            currentState = ParseState::NONE;
+            return true;
+        } else if (line == "DATA_BEGIN") {
+            currentState = ParseState::DATA;
+            return true;
+        } else if (line == "INSTRUCTIONS_BEGIN") {
+            currentState = ParseState::INSTRUCTIONS;
+            return true;
+        } else if (line == "INSTRUCTIONS_END") {
+            currentState = ParseState::END;
+            return false;
+        }
+
+        std::stringstream ss(line);
+        std::string keyword, param1, param2_str;
+        int param2_val;
+
+        if (currentState == ParseState::CONFIG) {
+            ss >> keyword;
+            if (keyword == "CYCLES") {
+                ss >> param1 >> param2_val;
+                config->ciclos[param1] = param2_val;
+            } else if (keyword == "UNITS") {
+                ss >> param1 >> param2_val;
+                config->unidades[param1] = param2_val;
+            } else if (keyword == "MEM_UNITS") {
+                ss >> param1 >> param2_val;
+                config->unidadesMem[param1] = param2_val;
+            } else if (keyword == "PIPES") { // "PIPES Mult 1 II 1"
+                ConfigPipeline pipeline;
+                ss >> param1 >> pipeline.quantidade;
+                if (ss >> param2_str && param2_str == "II") ss >> pipeline.intervalo;
+                ClasseUF classe = classePorNome(param1);
+                if (classe == ClasseUF::Nenhuma || classe == ClasseUF::Load || classe == ClasseUF::Store || pipeline.quantidade < 1 || pipeline.intervalo < 1) {
+                    std::cerr << "Warning: PIPES needs an arithmetic unit, a positive count and II in line: " << line << std::endl;
+                } else {
+                    config->pipelines[param1] = pipeline;
+                }
+            } else if (const ParametroEscalar* parametro = buscaParametroEscalar(keyword)) {
+                ss >> param1;
+                if (leValorParametro(*parametro, param1, param2_val)) {
+                    defineParametro(*config, *parametro, param2_val);
+                } else {
+                    std::cerr << "Warning: Invalid value '" << param1 << "' for " << keyword << " in line: " << line << std::endl;
+                }
+            } else {
+                std::cerr << "Warning: Unknown config keyword '" << keyword << "' in line: " << line << std::endl;
+            }
+        } else if (currentState == ParseState::DATA) { // "R1 64", "F2 1.5" ou "MEM endereco v1 v2 ..." (palavras de 8 bytes consecutivas)
+            ss >> keyword;
+            if (keyword == "MEM" && ss >> param1) {
+                uint64_t endereco = std::strtoull(param1.c_str(), nullptr, 0);
+                std::string valor;
+                while (ss >> valor && valor[0] != '#') {
+                    bool pontoFlutuante = literalPontoFlutuante(valor);
+                    config->dados.memoria.push_back({endereco, valorLiteral(valor, pontoFlutuante), pontoFlutuante});
+                    endereco += 8;
+                }
+            } else if (keyword != "MEM" && ss >> param1) {
+                config->dados.registradores[keyword] = valorLiteral(param1, ehRegistradorPF(keyword));
+            } else {
+                std::cerr << "Warning: Could not parse data line: " << line << std::endl;
+            }
+        } else if (currentState == ParseState::INSTRUCTIONS) {
+            std::string* campos[4] = {&instr.d_operacao, &instr.r_reg, &instr.s_reg_or_imm, &instr.t_reg_or_label};
+            std::string token;
+            int n = 0;
+            while (ss >> token) { // depois dos quatro campos, só um padrão "@" ainda é lido (o resto é comentário)
+                if (n == 0 && token.back() == ':') { // rótulo: vale para a próxima instrução
+                    rotuloPendente = token.substr(0, token.size() - 1);
+                } else if (token[0] == '@') {
+                    instr.padrao_desvio = token.substr(1);
+                } else if (n < 4) {
+                    *campos[n++] = token;
+                } else {
+                    break;
+                }
+            }
+            if (n == 0 && !rotuloPendente.empty()) return true; // linha só com o rótulo
+            if (instr.d_operacao.empty()) {
+                std::cerr << "Warning: Could not parse instruction line: " << line << std::endl;
+            }
+            instr.rotulo = rotuloPendente;
+            rotuloPendente.clear();
+        }
+        return true;
+    }
+};
+
+bool parseInputFile(const std::string& filename, ConfigSimulador& out_config, std::vector<InstrucaoInput>& out_instructions, std::string& out_rotuloNoFim) { //eitura do arquivo de entrada
+    LeitorTrace leitor;
+    if (!leitor.abre(filename, out_config)) {
+        return false;
+    }
+    InstrucaoInput instr;
+    while (leitor.proxima(instr)) {
+        out_instructions.push_back(instr);
+    }
+    out_config.numInstrucoes = out_instructions.size();
+    out_rotuloNoFim = leitor.rotuloNoFim();
+    return true;
+}
+
+class Decodificador { // converte InstrucaoInput em InstrucaoDecodificada, resolvendo nomes de registradores
+public:
+    Decodificador(const ConfigSimulador& config, ProgramaDecodificado& programa) : programa(programa) {
+        for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+            auto it = config.ciclos.find(NOMES_CLASSES_UF[c]);
+            latencias[c] = it != config.ciclos.end() ? it->second : -1;
+        }
+        for (int i = 0; i < 32; i += 2) {
+            programa.registradorInicial[registrador("F" + std::to_string(i))] = 1;
+        }
+        for (int i = 0; i < 32; ++i) {
+            programa.registradorInicial[registrador("R" + std::to_string(i))] = 1;
+        }
+        programa.idNaoAplicavel = programa.nomes.interna("N/A");
+    }
+
+    InstrucaoDecodificada decodifica(const InstrucaoInput& in) { // pode ser chamado instrução a instrução: uma fonte só é registrador se já tiver aparecido como tal
+        InstrucaoDecodificada d;
+        if (!in.rotulo.empty()) programa.rotulos[programa.nomes.interna(in.rotulo)] = indice;
+        indice++;
+        d.texto[0] = programa.nomes.interna(in.d_operacao);
+        d.texto[1] = textoOpcional(in.r_reg);
+        d.texto[2] = textoOpcional(in.s_reg_or_imm);
+        d.texto[3] = textoOpcional(in.t_reg_or_label);
+
+        const InfoOpcode* info = buscaOpcode(in.d_operacao);
+        if (!info) {
+            std::cerr << "WARN: Unknown operation for UF check: " << in.d_operacao << std::endl;
+            return d;
+        }
+        d.op = info->op;
+        d.classe = info->classe;
+        d.flags = info->flags;
+        avisaSemCiclos(d.classe, in.d_operacao);
+        if ((d.flags & ESCREVE_REGISTRADOR) && !in.r_reg.empty()) {
+            d.destino = registrador(in.r_reg);
+        }
+
+        if (d.flags & ACESSO_MEMORIA) {
+            d.fonteJ = operando(in.r_reg, false);
+            d.fonteK = operando(in.t_reg_or_label, false);
+            d.imediato = std::strtoll(in.s_reg_or_imm.c_str(), nullptr, 10);
+        } else if (d.flags & DESVIO) {
+            d.fonteJ = operando(in.r_reg, true);
+            d.fonteK = operando(in.s_reg_or_imm, true);
+            d.rotulo = in.t_reg_or_label.empty() ? d.texto[2] : d.texto[3];
+            d.padrao = textoOpcional(in.padrao_desvio);
+            if (d.rotulo != SEM_ID) desvios.emplace(d.rotulo, indice - 1);
+        } else {
+            d.fonteJ = operando(in.s_reg_or_imm, true);
+            d.fonteK = operando(in.t_reg_or_label, true);
+            d.imediato = std::strtoll(in.t_reg_or_label.c_str(), nullptr, 10);
+        }
+        return d;
+    }
+
+    void avisaRotulosIndefinidos(const std::string& rotuloNoFim) const { // depois da última instrução: o rótulo pode vir depois do desvio
+        for (const auto& e : desvios) {
+            const std::string& nome = programa.nomes.nome(e.first);
+            if (programa.rotulos.count(e.first) || nome == rotuloNoFim) continue;
+            std::cerr << "Warning: Label '" << nome << "' used by the branch at instruction " << e.second
+                      << " is not defined; taking that branch ends the program" << std::endl;
+        }
+    }
+
+private:
+    ProgramaDecodificado& programa;
+    int64_t indice = 0; // posição da próxima instrução no programa
+    std::map<uint32_t, int64_t> desvios; // id do nome do rótulo -> primeira instrução que desvia para ele
+    int latencias[NUM_CLASSES_UF];
+    std::vector<int32_t> registradorDoNome; // id de nome -> id de registrador (-1 se não for registrador)
+
+    uint32_t textoOpcional(const std::string& s) {
+        return s.empty() ? SEM_ID : programa.nomes.interna(s);
+    }
+
+    int32_t registrador(const std::string& nome) { // id do registrador, criando-o se ainda não existir
+        uint32_t id = programa.nomes.interna(nome);
+        if (registradorDoNome.size() <= id) registradorDoNome.resize(id + 1, -1);
+        if (registradorDoNome[id] < 0) {
+            registradorDoNome[id] = static_cast<int32_t>(programa.nomeRegistrador.size());
+            programa.nomeRegistrador.push_back(id);
+            programa.registradorInicial.push_back(0);
+            auto& ordem = programa.ordemRegistradores; // mantida em ordem alfabética de nome (ordem de impressão)
+            auto pos = std::lower_bound(ordem.begin(), ordem.end(), nome, [&](uint32_t r, const std::string& n) {
+                return programa.nomes.nome(programa.nomeRegistrador[r]) < n;
+            });
+            ordem.insert(pos, static_cast<uint32_t>(registradorDoNome[id]));
+        }
+        return registradorDoNome[id];
+    }
+
+    void avisaSemCiclos(ClasseUF classe, const std::string& op) { // avisa uma única vez quando a classe não tem CYCLES (a latência fica 1)
+        int& l = latencias[static_cast<int>(classe)];
+        if (l < 0) {
+            std::cerr << "Error: Cycle count not found for FU type '" << NOMES_CLASSES_UF[static_cast<int>(classe)]
+                      << "' derived from operation '" << op << "'" << std::endl;
+            l = 1;
+        }
+    }
+
+    OperandoDecodificado operando(const std::string& nome, bool aritmetico) { // nas aritméticas, só nomes iniciados por F/R podem depender de outra estação
+        OperandoDecodificado o;
+        if (nome.empty()) return o;
+        o.nome = programa.nomes.interna(nome);
+        if (aritmetico && nome[0] != 'F' && nome[0] != 'R') return o;
+        if (o.nome < registradorDoNome.size()) o.registrador = registradorDoNome[o.nome];
+        return o;
+    }
+};
+
+void decodificaPrograma(const ConfigSimulador& config, const std::vector<InstrucaoInput>& instrucoes, const std::string& rotuloNoFim,
+                        ProgramaDecodificado& out_programa) { // decodifica todas as instruções uma única vez, logo após a leitura
+    Decodificador decodificador(config, out_programa);
+    out_programa.instrucoes.reserve(instrucoes.size());
+    for (const auto& in : instrucoes) {
+        out_programa.instrucoes.push_back(decodificador.decodifica(in));
+    }
+    decodificador.avisaRotulosIndefinidos(rotuloNoFim);
+}
+
+class FonteArquivo : public FonteInstrucoes { // lê e decodifica o arquivo de entrada sob demanda, sem carregá-lo inteiro
+public:
+    bool abre(const std::string& filename, ConfigSimulador& out_config) {
+        if (!leitor.abre(filename, out_config)) return false;
+        programa = std::make_shared<ProgramaDecodificado>();
+        decodificador = std::make_unique<Decodificador>(out_config, *programa);
+        return true;
+    }
+
+    bool proxima(InstrucaoDecodificada& out) override {
+        InstrucaoInput in;
+        if (adiantada) {
+            in = std::move(*adiantada);
+            adiantada.reset();
+        } else if (!leitor.proxima(in)) {
+            if (!esgotada) decodificador->avisaRotulosIndefinidos(leitor.rotuloNoFim());
+            esgotada = true;
+            return false;
+        }
+        out = decodificador->decodifica(in);
+        return true;
+    }
+    bool vazia() override { // lê a próxima linha sem decodificá-la: os ids dos nomes seguem a ordem de decodificação
+        if (adiantada) return false;
+        InstrucaoInput in;
+        if (!leitor.proxima(in)) return true;
+        adiantada = std::move(in);
+        return false;
+    }
+
+    std::shared_ptr<ProgramaDecodificado> programa; // nomes e registradores vistos até agora; instrucoes fica vazio
+
+private:
+    LeitorTrace leitor;
+    std::unique_ptr<Decodificador> decodificador;
+    std::optional<InstrucaoInput> adiantada; // lida por vazia() e ainda não entregue
+    bool esgotada = false;
+};
+
+// gerador de carga sintética: tipos de instrução sorteados pelos pesos do mix; cada fonte lê o destino
+// de uma instrução anterior da mesma família (F ou R), a uma distância sorteada com média `distancia`
+enum TipoSintetico { SintAdd, SintMul, SintDiv, SintLoad, SintStore, SintInteiro, SintDesvio, NUM_TIPOS_SINTETICOS };
+const char* const NOMES_TIPOS_SINTETICOS[NUM_TIPOS_SINTETICOS] = {"add", "mul", "div", "load", "store", "int", "desvio"};
+
+struct ParametrosSinteticos {
+    int64_t tamanho = 1000000;
+    int pesos[NUM_TIPOS_SINTETICOS] = {30, 15, 3, 20, 10, 15, 7};
+    double distancia = 4;
+    uint64_t semente = 1;
+};
+
+bool parseMix(const std::string& texto, ParametrosSinteticos& out) { // "add=30,mul=15,..."; tipos omitidos ficam com peso 0
+    std::fill(out.pesos, out.pesos + NUM_TIPOS_SINTETICOS, 0);
+    std::stringstream ss(texto);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t igual = item.find('=');
+        std::string nome = item.substr(0, igual);
+        int t = 0;
+        while (t < NUM_TIPOS_SINTETICOS && nome != NOMES_TIPOS_SINTETICOS[t]) ++t;
+        if (igual == std::string::npos || t == NUM_TIPOS_SINTETICOS) {
+            std::cerr << "Error: Invalid mix entry '" << item << "' (expected add|mul|div|load|store|int|desvio=<peso>)" << std::endl;
+            return false;
+        }
+        out.pesos[t] = std::max(0, std::atoi(item.c_str() + igual + 1));
+    }
+    if (std::accumulate(out.pesos, out.pesos + NUM_TIPOS_SINTETICOS, 0) == 0) {
+        std::cerr << "Error: Mix '" << texto << "' has no positive weight" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+class GeradorSintetico {
+public:
+    static constexpr int64_t TAMANHO_BLOCO = 65536; // cada bloco começa com o rótulo L<k>; os desvios saltam para o do bloco seguinte
+
+    static std::string rotulo(int64_t indice) { return "L" + std::to_string(indice / TAMANHO_BLOCO); } // do bloco que contém a instrução
+
+    explicit GeradorSintetico(const ParametrosSinteticos& p)
+        : params(p), rng(p.semente), tipo(p.pesos, p.pesos + NUM_TIPOS_SINTETICOS),
+          distancia(1.0 / std::max(1.0, p.distancia)), imediato(0, 63) {}
+
+    bool proxima(InstrucaoInput& out) {
+        if (geradas >= params.tamanho) return false;
+        out = InstrucaoInput();
+        if (geradas % TAMANHO_BLOCO == 0) out.rotulo = rotulo(geradas);
+        switch (tipo(rng)) {
+        case SintAdd: aritmetica(out, geradas % 2 ? "SUBD" : "ADDD"); break;
+        case SintMul: aritmetica(out, "MULTD"); break;
+        case SintDiv: aritmetica(out, "DIVD"); break;
+        case SintLoad:
+            out.d_operacao = "LD";
+            out.s_reg_or_imm = std::to_string(imediato(rng));
+            out.t_reg_or_label = fonte(historicoR);
+            out.r_reg = destino(historicoF, 'F', 2);
+            break;
+        case SintStore:
+            out.d_operacao = "SD";
+            out.r_reg = fonte(historicoF);
+            out.s_reg_or_imm = std::to_string(imediato(rng));
+            out.t_reg_or_label = fonte(historicoR);
+            break;
+        case SintInteiro:
+            out.d_operacao = "DADDUI";
+            out.s_reg_or_imm = fonte(historicoR);
+            out.t_reg_or_label = std::to_string(imediato(rng));
+            out.r_reg = destino(historicoR, 'R', 1);
+            break;
+        default:
+            out.d_operacao = "BNEZ";
+            out.r_reg = fonte(historicoR);
+            out.t_reg_or_label = rotulo(geradas + TAMANHO_BLOCO);
+            break;
+        }
+        ++geradas;
+        return true;
+    }
+
+private:
+    static constexpr int NUM_REGISTRADORES = 16; // destinos em rodízio: F0..F30 pares e R1..R16
+    ParametrosSinteticos params;
+    std::mt19937_64 rng;
+    std::discrete_distribution<int> tipo;
+    std::geometric_distribution<int> distancia;
+    std::uniform_int_distribution<int> imediato;
+    std::vector<std::string> historicoF, historicoR; // destinos recentes, o mais novo no fim
+    int64_t geradas = 0;
+    int proximoF = 0, proximoR = 0;
+
+    void aritmetica(InstrucaoInput& out, const char* op) {
+        out.d_operacao = op;
+        out.s_reg_or_imm = fonte(historicoF);
+        out.t_reg_or_label = fonte(historicoF);
+        out.r_reg = destino(historicoF, 'F', 2);
+    }
+
+    std::string fonte(const std::vector<std::string>& historico) {
+        int d = 1 + distancia(rng);
+        if (historico.empty()) return &historico == &historicoF ? "F0" : "R0";
+        if (d > static_cast<int>(historico.size())) d = static_cast<int>(historico.size());
+        return historico[historico.size() - d];
+    }
+
+    std::string destino(std::vector<std::string>& historico, char prefixo, int passo) {
+        int& proximo = prefixo == 'F' ? proximoF : proximoR;
+        std::string r = prefixo + std::to_string(prefixo == 'F' ? proximo * passo : proximo + 1);
+        proximo = (proximo + 1) % NUM_REGISTRADORES;
+        if (historico.size() == NUM_REGISTRADORES - 1) historico.erase(historico.begin()); // além disso o registrador já foi reescrito
+        historico.push_back(r);
+        return r;
+    }
+};
+
+ConfigSimulador configSintetica() { // a mesma configuração de input2.txt
+    ConfigSimulador c;
+    c.ciclos = {{"Integer", 1}, {"Load", 2}, {"Store", 2}, {"Add", 2}, {"Mult", 10}, {"Div", 40}};
+    c.unidades = {{"Integer", 3}, {"Add", 3}, {"Mult", 2}, {"Div", 1}};
+    c.unidadesMem = {{"Load", 6}, {"Store", 3}};
+    return c;
+}
+
+void escreveConfig(std::ostream& out, const ConfigSimulador& config) { // bloco CONFIG_BEGIN (sem o DATA), só com os parâmetros fora do padrão
+    out << "CONFIG_BEGIN\n";
+    for (const auto& e : config.ciclos) out << "CYCLES " << e.first << ' ' << e.second << '\n';
+    for (const auto& e : config.unidades) out << "UNITS " << e.first << ' ' << e.second << '\n';
+    for (const auto& e : config.unidadesMem) out << "MEM_UNITS " << e.first << ' ' << e.second << '\n';
+    for (const auto& e : config.pipelines) out << "PIPES " << e.first << ' ' << e.second.quantidade << " II " << e.second.intervalo << '\n';
+    for (const auto& p : PARAMETROS_ESCALARES) {
+        if (config.*p.campo != p.padrao) out << p.chave << ' ' << textoParametro(p, config.*p.campo) << '\n';
+    }
+    out << "CONFIG_END\n";
+}
+
+bool escreveTraceSintetico(const std::string& saida, const ConfigSimulador& config, const ParametrosSinteticos& params) { // grava no formato texto de entrada
+    std::ofstream out(saida);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << saida << std::endl;
+        return false;
+    }
+    escreveConfig(out, config);
+    out << "\nINSTRUCTIONS_BEGIN\n";
+    GeradorSintetico gerador(params);
+    InstrucaoInput in;
+    while (gerador.proxima(in)) {
+        if (!in.rotulo.empty()) out << in.rotulo << ": ";
+        out << in.d_operacao << ' ' << in.r_reg << ' ';
+        if (!in.s_reg_or_imm.empty()) out << in.s_reg_or_imm << ' ';
+        out << in.t_reg_or_label << '\n';
+    }
+    if (params.tamanho > 0) out << GeradorSintetico::rotulo(params.tamanho + GeradorSintetico::TAMANHO_BLOCO - 1) << ":\n"; // alvo dos desvios do último bloco
+    out << "INSTRUCTIONS_END\n";
+    return static_cast<bool>(out);
+}
+
+class FonteSintetica : public FonteInstrucoes { // decodifica um bloco do gerador uma vez e o repete até o tamanho pedido
+public:
+    FonteSintetica(const ConfigSimulador& config, const ParametrosSinteticos& params) : tamanho(params.tamanho) {
+        programa = std::make_shared<ProgramaDecodificado>();
+        Decodificador decodificador(config, *programa);
+        GeradorSintetico gerador(params);
+        InstrucaoInput in;
+        while (static_cast<int64_t>(bloco.size()) < GeradorSintetico::TAMANHO_BLOCO && gerador.proxima(in)) {
+            bloco.push_back(decodificador.decodifica(in));
+        }
+        programa->periodo = static_cast<int64_t>(bloco.size());
+    }
+
+    bool proxima(InstrucaoDecodificada& out) override {
+        if (i >= tamanho || bloco.empty()) return false;
+        out = bloco[i++ % bloco.size()];
+        return true;
+    }
+    bool vazia() override { return i >= tamanho || bloco.empty(); }
+    bool posiciona(int64_t indice) override {
+        i = std::min(indice, tamanho);
+        return true;
+    }
+
+    std::shared_ptr<ProgramaDecodificado> programa;
+
+private:
+    std::vector<InstrucaoDecodificada> bloco;
+    int64_t tamanho;
+    int64_t i = 0;
+};
+
+// Formato binário de trace (.trc), little-endian:
+//   cabeçalho de 64 bytes | numInstrucoes registros de 40 bytes | tabelas
+// As tabelas (configuração, nomes e registradores) ficam depois dos registros para que o conversor
+// possa gravá-los à medida que decodifica, sem manter o trace em memória.
+constexpr char MAGICA_TRACE[8] = {'T', 'O', 'M', 'A', 'S', 'T', 'R', 'C'};
+constexpr uint32_t VERSAO_TRACE = 1;
+constexpr int NUM_PARAMETROS_CABECALHO = 4;
+
+struct CabecalhoTrace {
+    char magica[8];
+    uint32_t versao;
+    uint32_t tamanhoRegistro;
+    uint64_t numInstrucoes;
+    uint64_t offsetRegistros;
+    uint64_t offsetTabelas;
+    uint64_t tamanhoTabelas;
+    int32_t parametros[NUM_PARAMETROS_CABECALHO]; // os primeiros de PARAMETROS_ESCALARES; os demais vão nas tabelas
+};
+static_assert(sizeof(CabecalhoTrace) == 64, "cabecalho do trace deve ter 64 bytes");
+
+struct RegistroTrace { // InstrucaoDecodificada com largura fixa; latência, nomes das fontes e rótulo são derivados na leitura
+    int64_t imediato;        // nos desvios (sem imediato), o id do padrão de resultados
+    uint32_t texto[4];
+    int32_t destino;
+    int32_t fonteJRegistrador;
+    int32_t fonteKRegistrador;
+    uint8_t op;
+    uint8_t classe;
+    uint8_t flags;
+    uint8_t reservado;
+};
+static_assert(sizeof(RegistroTrace) == 40, "registro do trace deve ter 40 bytes");
+
+RegistroTrace paraRegistro(const InstrucaoDecodificada& d) {
+    RegistroTrace r = {};
+    r.imediato = (d.flags & DESVIO) ? static_cast<int64_t>(d.padrao) : d.imediato;
+    std::copy(d.texto, d.texto + 4, r.texto);
+    r.destino = d.destino;
+    r.fonteJRegistrador = d.fonteJ.registrador;
+    r.fonteKRegistrador = d.fonteK.registrador;
+    r.op = static_cast<uint8_t>(d.op);
+    r.classe = static_cast<uint8_t>(d.classe);
+    r.flags = d.flags;
+    return r;
+}
+
+InstrucaoDecodificada deRegistro(const RegistroTrace& r) {
+    InstrucaoDecodificada d;
+    d.op = static_cast<Opcode>(r.op);
+    d.classe = static_cast<ClasseUF>(r.classe);
+    d.flags = r.flags;
+    d.destino = r.destino;
+    d.imediato = r.imediato;
+    std::copy(r.texto, r.texto + 4, d.texto);
+    if (d.classe == ClasseUF::Nenhuma) return d;
+
+    if (d.flags & ACESSO_MEMORIA) { // mesmos campos usados por Decodificador::decodifica
+        d.fonteJ.nome = r.texto[1];
+        d.fonteK.nome = r.texto[3];
+    } else if (d.flags & DESVIO) {
+        d.fonteJ.nome = r.texto[1];
+        d.fonteK.nome = r.texto[2];
+        d.rotulo = r.texto[3] == SEM_ID ? r.texto[2] : r.texto[3];
+        d.padrao = static_cast<uint32_t>(r.imediato);
+        d.imediato = 0;
+    } else {
+        d.fonteJ.nome = r.texto[2];
+        d.fonteK.nome = r.texto[3];
+    }
+    d.fonteJ.registrador = r.fonteJRegistrador;
+    d.fonteK.registrador = r.fonteKRegistrador;
+    return d;
+}
+
+template <typename T>
+void gravaValor(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+bool converteTrace(const std::string& entrada, const std::string& saida) { // converte o formato texto para o binário em uma única passada
+    ConfigSimulador config;
+    LeitorTrace leitor;
+    if (!leitor.abre(entrada, config)) return false;
+    std::ofstream out(saida, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << saida << std::endl;
+        return false;
+    }
+
+    ProgramaDecodificado programa;
+    Decodificador decodificador(config, programa);
+    CabecalhoTrace cab = {};
+    std::copy(MAGICA_TRACE, MAGICA_TRACE + 8, cab.magica);
+    cab.versao = VERSAO_TRACE;
+    cab.tamanhoRegistro = sizeof(RegistroTrace);
+    cab.offsetRegistros = sizeof(CabecalhoTrace);
+    for (int k = 0; k < NUM_PARAMETROS_CABECALHO; ++k) cab.parametros[k] = config.*PARAMETROS_ESCALARES[k].campo;
+    gravaValor(out, cab);
+
+    InstrucaoInput in;
+    while (leitor.proxima(in)) {
+        gravaValor(out, paraRegistro(decodificador.decodifica(in)));
+        cab.numInstrucoes++;
+    }
+    decodificador.avisaRotulosIndefinidos(leitor.rotuloNoFim());
+
+    cab.offsetTabelas = static_cast<uint64_t>(out.tellp());
+    const std::map<std::string, int>* secoes[3] = {&config.ciclos, &config.unidades, &config.unidadesMem}; // CYCLES, UNITS, MEM_UNITS
+    for (const auto* secao : secoes) {
+        gravaValor(out, static_cast<uint32_t>(secao->size()));
+        for (const auto& pair : *secao) {
+            gravaValor(out, programa.nomes.interna(pair.first));
+            gravaValor(out, static_cast<int32_t>(pair.second));
+        }
+    }
+    gravaValor(out, static_cast<uint32_t>(programa.nomes.size()));
+    for (uint32_t i = 0; i < programa.nomes.size(); ++i) {
+        const std::string& nome = programa.nomes.nome(i);
+        gravaValor(out, static_cast<uint32_t>(nome.size()));
+        out.write(nome.data(), nome.size());
+    }
+    gravaValor(out, static_cast<uint32_t>(programa.nomeRegistrador.size()));
+    for (size_t r = 0; r < programa.nomeRegistrador.size(); ++r) {
+        gravaValor(out, programa.nomeRegistrador[r]);
+        gravaValor(out, programa.registradorInicial[r]);
+    }
+    for (uint32_t r : programa.ordemRegistradores) {
+        gravaValor(out, r);
+    }
+    gravaValor(out, programa.idNaoAplicavel);
+    gravaValor(out, static_cast<uint32_t>(programa.rotulos.size()));
+    for (const auto& e : programa.rotulos) {
+        gravaValor(out, e.first);
+        gravaValor(out, e.second);
+    }
+    gravaValor(out, static_cast<uint32_t>(NUM_PARAMETROS_ESCALARES - NUM_PARAMETROS_CABECALHO)); // índice em PARAMETROS_ESCALARES e valor
+    for (int k = NUM_PARAMETROS_CABECALHO; k < NUM_PARAMETROS_ESCALARES; ++k) {
+        gravaValor(out, static_cast<uint32_t>(k));
+        gravaValor(out, static_cast<int32_t>(config.*PARAMETROS_ESCALARES[k].campo));
+    }
+    gravaValor(out, static_cast<uint32_t>(config.dados.registradores.size())); // bloco de dados
+    for (const auto& e : config.dados.registradores) { // o nome vai por extenso: a tabela de nomes já foi gravada
+        gravaValor(out, static_cast<uint32_t>(e.first.size()));
+        out.write(e.first.data(), e.first.size());
+        gravaValor(out, e.second);
+    }
+    gravaValor(out, static_cast<uint64_t>(config.dados.memoria.size()));
+    for (const auto& palavra : config.dados.memoria) {
+        gravaValor(out, palavra.endereco);
+        gravaValor(out, palavra.valor);
+        gravaValor(out, static_cast<uint8_t>(palavra.pontoFlutuante));
+    }
+    gravaValor(out, static_cast<uint32_t>(config.pipelines.size())); // PIPES, também com o nome por extenso
+    for (const auto& e : config.pipelines) {
+        gravaValor(out, static_cast<uint32_t>(e.first.size()));
+        out.write(e.first.data(), e.first.size());
+        gravaValor(out, static_cast<int32_t>(e.second.quantidade));
+        gravaValor(out, static_cast<int32_t>(e.second.intervalo));
+    }
+    cab.tamanhoTabelas = static_cast<uint64_t>(out.tellp()) - cab.offsetTabelas;
+
+    out.seekp(0);
+    gravaValor(out, cab);
+    if (!out.good()) {
+        std::cerr << "Error: Could not write file " << saida << std::endl;
+        return false;
+    }
+    std::cout << cab.numInstrucoes << " instrucoes convertidas para " << saida << std::endl;
+    return true;
+}
+
+class TraceBinario { // trace binário mapeado em memória; os registros são lidos direto do mapeamento
+public:
+    ~TraceBinario() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapa) munmap(mapa, tamanho);
+#endif
+    }
+
+    static bool ehTraceBinario(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        char magica[8] = {};
+        in.read(magica, 8);
+        return in.gcount() == 8 && std::equal(magica, magica + 8, MAGICA_TRACE);
+    }
+
+    bool abre(const std::string& filename, ConfigSimulador& out_config) {
+        if (!mapeia(filename)) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        CabecalhoTrace cab;
+        if (tamanho < sizeof(cab)) return invalido(filename);
+        std::copy(dados, dados + sizeof(cab), reinterpret_cast<char*>(&cab));
+        if (cab.versao != VERSAO_TRACE || cab.tamanhoRegistro != sizeof(RegistroTrace) || cab.offsetRegistros > tamanho ||
+            cab.numInstrucoes > (tamanho - cab.offsetRegistros) / sizeof(RegistroTrace) || cab.offsetTabelas > tamanho ||
+            cab.tamanhoTabelas > tamanho - cab.offsetTabelas) { // sem somas: offsets corrompidos não dão a volta em 64 bits
+            return invalido(filename);
+        }
+        registros = dados + cab.offsetRegistros;
+        numInstrucoes = cab.numInstrucoes;
+        for (int k = 0; k < NUM_PARAMETROS_CABECALHO; ++k) defineParametro(out_config, PARAMETROS_ESCALARES[k], cab.parametros[k]);
+
+        const char* p = dados + cab.offsetTabelas;
+        const char* fim = p + cab.tamanhoTabelas;
+        std::vector<std::pair<uint32_t, int32_t>> secoes[3];
+        programa = std::make_shared<ProgramaDecodificado>();
+        for (auto& secao : secoes) {
+            uint32_t n;
+            if (!leValor(p, fim, n) || n > static_cast<size_t>(fim - p) / 8) return invalido(filename); // cada entrada tem 8 bytes
+            secao.resize(n);
+            for (auto& e : secao) {
+                if (!leValor(p, fim, e.first) || !leValor(p, fim, e.second)) return invalido(filename);
+            }
+        }
+        uint32_t numNomes;
+        if (!leValor(p, fim, numNomes)) return invalido(filename);
+        for (uint32_t i = 0; i < numNomes; ++i) {
+            uint32_t len;
+            if (!leValor(p, fim, len) || static_cast<size_t>(fim - p) < len) return invalido(filename);
+            programa->nomes.interna(std::string(p, len));
+            p += len;
+        }
+        uint32_t numRegistradores;
+        if (!leValor(p, fim, numRegistradores) || numRegistradores > static_cast<size_t>(fim - p) / 9) return invalido(filename);
+        programa->nomeRegistrador.resize(numRegistradores);
+        programa->registradorInicial.resize(numRegistradores);
+        programa->ordemRegistradores.resize(numRegistradores);
+        for (uint32_t r = 0; r < numRegistradores; ++r) {
+            if (!leValor(p, fim, programa->nomeRegistrador[r]) || !leValor(p, fim, programa->registradorInicial[r])) return invalido(filename);
+        }
+        for (uint32_t r = 0; r < numRegistradores; ++r) {
+            if (!leValor(p, fim, programa->ordemRegistradores[r])) return invalido(filename);
+            if (programa->nomeRegistrador[r] >= numNomes || programa->ordemRegistradores[r] >= numRegistradores) return invalido(filename);
+        }
+        if (!leValor(p, fim, programa->idNaoAplicavel) || !idValido(programa->idNaoAplicavel, numNomes)) return invalido(filename);
+        uint32_t numRotulos = 0;
+        if (p < fim && !leValor(p, fim, numRotulos)) return invalido(filename); // ausente em traces anteriores aos rótulos
+        for (uint32_t i = 0; i < numRotulos; ++i) {
+            uint32_t nome;
+            int64_t indice;
+            if (!leValor(p, fim, nome) || !leValor(p, fim, indice)) return invalido(filename);
+            if (nome >= numNomes || indice < 0 || static_cast<uint64_t>(indice) > numInstrucoes) return invalido(filename);
+            programa->rotulos[nome] = indice;
+        }
+        uint32_t numParametros = 0;
+        if (p < fim && !leValor(p, fim, numParametros)) return invalido(filename); // idem, parâmetros além do cabeçalho
+        for (uint32_t i = 0; i < numParametros; ++i) {
+            uint32_t k;
+            int32_t valor;
+            if (!leValor(p, fim, k) || !leValor(p, fim, valor)) return invalido(filename);
+            if (k < static_cast<uint32_t>(NUM_PARAMETROS_ESCALARES)) defineParametro(out_config, PARAMETROS_ESCALARES[k], valor);
+        }
+        uint32_t numValores = 0;
+        if (p < fim && !leValor(p, fim, numValores)) return invalido(filename); // idem, bloco de dados
+        for (uint32_t i = 0; i < numValores; ++i) {
+            uint32_t len;
+            uint64_t valor;
+            if (!leValor(p, fim, len) || static_cast<size_t>(fim - p) < len) return invalido(filename);
+            std::string nome(p, len);
+            p += len;
+            if (!leValor(p, fim, valor)) return invalido(filename);
+            out_config.dados.registradores[nome] = valor;
+        }
+        uint64_t numPalavras = 0;
+        if (p < fim && !leValor(p, fim, numPalavras)) return invalido(filename);
+        for (uint64_t i = 0; i < numPalavras; ++i) {
+            PalavraInicial palavra;
+            uint8_t pontoFlutuante;
+            if (!leValor(p, fim, palavra.endereco) || !leValor(p, fim, palavra.valor) || !leValor(p, fim, pontoFlutuante)) return invalido(filename);
+            palavra.pontoFlutuante = pontoFlutuante != 0;
+            out_config.dados.memoria.push_back(palavra);
+        }
+        uint32_t numPipelines = 0;
+        if (p < fim && !leValor(p, fim, numPipelines)) return invalido(filename); // idem, PIPES
+        for (uint32_t i = 0; i < numPipelines; ++i) {
+            uint32_t len;
+            ConfigPipeline pipeline;
+            if (!leValor(p, fim, len) || static_cast<size_t>(fim - p) < len) return invalido(filename);
+            std::string nome(p, len);
+            p += len;
+            if (!leValor(p, fim, pipeline.quantidade) || !leValor(p, fim, pipeline.intervalo)) return invalido(filename);
+            out_config.pipelines[nome] = pipeline;
+        }
+
+        std::map<std::string, int>* destinos[3] = {&out_config.ciclos, &out_config.unidades, &out_config.unidadesMem};
+        for (int i = 0; i < 3; ++i) {
+            for (const auto& e : secoes[i]) {
+                if (e.first >= numNomes) return invalido(filename);
+                (*destinos[i])[programa->nomes.nome(e.first)] = e.second;
+            }
+        }
+        uint16_t esperado[256]; // classe e flags de cada op (0xFFFF: op inexistente)
+        std::fill(esperado, esperado + 256, 0xFFFF);
+        esperado[static_cast<uint8_t>(Opcode::Desconhecido)] = static_cast<uint16_t>(static_cast<uint8_t>(ClasseUF::Nenhuma) << 8); // como o decodificador a deixa
+        for (const auto& info : TABELA_OPCODES) esperado[static_cast<uint8_t>(info.op)] = static_cast<uint16_t>(static_cast<uint8_t>(info.classe) << 8 | info.flags);
+        for (uint64_t i = 0; i < numInstrucoes; ++i) { // o simulador indexa tabelas com os ids dos registros sem conferir
+            RegistroTrace r;
+            std::copy(registros + i * sizeof(RegistroTrace), registros + (i + 1) * sizeof(RegistroTrace), reinterpret_cast<char*>(&r));
+            if (esperado[r.op] != (r.classe << 8 | r.flags) || !registroValido(r, numNomes, numRegistradores)) return invalido(filename);
+        }
+        out_config.numInstrucoes = static_cast<int>(numInstrucoes);
+        return true;
+    }
+
+    InstrucaoDecodificada instrucao(uint64_t i) const {
+        RegistroTrace r;
+        std::copy(registros + i * sizeof(RegistroTrace), registros + (i + 1) * sizeof(RegistroTrace), reinterpret_cast<char*>(&r));
+        return deRegistro(r);
+    }
+
+    std::shared_ptr<ProgramaDecodificado> programa; // nomes e registradores do trace; instrucoes fica vazio
+    uint64_t numInstrucoes = 0;
+
+private:
+    char* mapa = nullptr;
+    std::vector<char> copia; // usado onde não há mmap
+    const char* dados = nullptr;
+    const char* registros = nullptr;
+    size_t tamanho = 0;
+
+    bool mapeia(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        tamanho = static_cast<size_t>(st.st_size);
+        void* m = mmap(nullptr, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) return false;
+        madvise(m, tamanho, MADV_SEQUENTIAL);
+        mapa = static_cast<char*>(m);
+        dados = mapa;
+#else
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) return false;
+        copia.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        tamanho = copia.size();
+        dados = copia.data();
+#endif
+        return true;
+    }
+
+    template <typename T>
+    static bool leValor(const char*& p, const char* fim, T& v) {
+        if (static_cast<size_t>(fim - p) < sizeof(T)) return false;
+        std::copy(p, p + sizeof(T), reinterpret_cast<char*>(&v));
+        p += sizeof(T);
+        return true;
+    }
+
+    static bool idValido(uint32_t id, uint32_t numNomes) { return id == SEM_ID || id < numNomes; }
+
+    static bool registroValido(const RegistroTrace& r, uint32_t numNomes, uint32_t numRegistradores) { // ids dentro das tabelas
+        for (int32_t reg : {r.destino, r.fonteJRegistrador, r.fonteKRegistrador}) {
+            if (reg < -1 || (reg >= 0 && static_cast<uint32_t>(reg) >= numRegistradores)) return false;
+        }
+        for (uint32_t id : r.texto) {
+            if (!idValido(id, numNomes)) return false;
+        }
+        if ((r.flags & DESVIO) && (r.imediato < 0 || r.imediato > SEM_ID || !idValido(static_cast<uint32_t>(r.imediato), numNomes))) return false; // o padrão
+        return true;
+    }
+
+    static bool invalido(const std::string& filename) {
+        std::cerr << "Error: Invalid binary trace " << filename << std::endl;
+        return false;
+    }
+};
+
+class FonteBinaria : public FonteInstrucoes { // percorre os registros de um TraceBinario
+public:
+    explicit FonteBinaria(std::shared_ptr<const TraceBinario> trace) : trace(std::move(trace)) {}
+    bool proxima(InstrucaoDecodificada& out) override {
+        if (i >= trace->numInstrucoes) return false;
+        out = trace->instrucao(i++);
+        return true;
+    }
+    bool vazia() override { return i >= trace->numInstrucoes; }
+    bool posiciona(int64_t indice) override {
+        i = static_cast<uint64_t>(std::min<int64_t>(indice, static_cast<int64_t>(trace->numInstrucoes)));
+        return true;
+    }
+
+private:
+    std::shared_ptr<const TraceBinario> trace;
+    uint64_t i = 0;
+};
+
+// Checkpoint (.ckp): mágica, versão e a soma de verificação do resto, que é o bloco de configuração e o número de
+// instruções e de nomes do programa (para recusar um checkpoint de outro trace ou configuração), seguidos de
+// Estado::serializa. Não é portável entre plataformas: serve para voltar ao mesmo ponto com o mesmo binário
+constexpr char MAGICA_CHECKPOINT[8] = {'T', 'O', 'M', 'A', 'S', 'C', 'K', 'P'};
+constexpr uint32_t VERSAO_CHECKPOINT = 3;
+
+uint64_t somaVerificacao(const std::string& bytes) { // FNV-1a de 64 bits
+    uint64_t h = 14695981039346656037ull;
+    for (char c : bytes) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string identificacaoCheckpoint(const Estado& estado, bool comPrograma) { // o bloco de configuração e, depois dele, o tamanho do programa
+    std::ostringstream out;
+    escreveConfig(out, estado.config);
+    if (comPrograma) out << estado.config.numInstrucoes << ' ' << estado.programa->nomes.size() << '\n';
+    return out.str();
+}
+
+bool gravaCheckpoint(const std::string& arquivo, Estado& estado) {
+    std::ofstream out(arquivo, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << arquivo << std::endl;
+        return false;
+    }
+    std::ostringstream carga; // montada antes, para a soma de verificação ir à frente
+    ArquivoEstado a(carga);
+    std::string id = identificacaoCheckpoint(estado, true);
+    std::vector<char> texto(id.begin(), id.end());
+    a.campo(texto);
+    estado.serializa(a);
+    std::string bytes = carga.str();
+    out.write(MAGICA_CHECKPOINT, 8);
+    gravaValor(out, VERSAO_CHECKPOINT);
+    gravaValor(out, somaVerificacao(bytes));
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!a.ok() || !out) {
+        std::cerr << "Error: Could not write file " << arquivo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool restauraCheckpoint(const std::string& arquivo, Estado& estado) { // estado recém-criado com o mesmo trace e configuração
+    std::ifstream in(arquivo, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open file " << arquivo << std::endl;
+        return false;
+    }
+    uint64_t tamanho = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    ArquivoEstado cabecalho(in, tamanho);
+    char magica[8] = {};
+    uint32_t versao = 0;
+    uint64_t soma = 0;
+    cabecalho.campo(magica);
+    cabecalho.campo(versao);
+    cabecalho.campo(soma);
+    std::string bytes;
+    if (cabecalho.ok()) { // o estado só é lido com a soma conferida: um arquivo corrompido para aqui
+        bytes.resize(tamanho - sizeof(magica) - sizeof(versao) - sizeof(soma));
+        in.read(&bytes[0], static_cast<std::streamsize>(bytes.size()));
+    }
+    std::istringstream carga(bytes);
+    ArquivoEstado a(carga, bytes.size());
+    std::vector<char> texto;
+    if (!cabecalho.ok() || !in || !std::equal(magica, magica + 8, MAGICA_CHECKPOINT) || versao != VERSAO_CHECKPOINT ||
+        somaVerificacao(bytes) != soma) {
+        a.falha();
+    }
+    if (a.ok()) a.campo(texto);
+    if (!a.ok()) {
+        std::cerr << "Error: Invalid checkpoint " << arquivo << std::endl;
+        return false;
+    }
+    std::string id(texto.begin(), texto.end());
+    std::string config = identificacaoCheckpoint(estado, false);
+    bool mesmoPrograma = id.compare(0, config.size(), config) == 0;
+    if (mesmoPrograma) {
+        estado.serializa(a);
+        // com um trace lido sob demanda, a tabela de nomes só fica completa depois de a fonte ser reposicionada
+        mesmoPrograma = !a.ok() || id == identificacaoCheckpoint(estado, true);
+    }
+    if (!mesmoPrograma) {
+        std::cerr << "Error: Checkpoint " << arquivo << " was taken with a different trace or configuration" << std::endl;
+        return false;
+    }
+    if (!a.ok()) {
+        std::cerr << "Error: Invalid checkpoint " << arquivo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+enum class FormatoRelatorio { Texto, Csv, Json };
+
+struct ResumoExecucao {
+    std::string situacao; // concluida, travada ou limite
+    int64_t ciclos;
+    int64_t instrucoes;
+};
+
+std::string textoCiclo(int64_t c, const char* ausente) {
+    return c < 0 ? ausente : std::to_string(c);
+}
+
+std::string textoJson(const std::string& s) {
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        r += c;
+    }
+    return r + "\"";
+}
+
+double taxaAcerto(int64_t acessos, int64_t faltas) { return acessos > 0 ? 1.0 - static_cast<double>(faltas) / acessos : 1.0; }
+
+std::vector<std::pair<std::string, double>> metricas(const Contadores& c) { // chaves usadas nos relatórios CSV e JSON
+    double ciclos = c.ciclos > 0 ? static_cast<double>(c.ciclos) : 1.0;
+    std::vector<std::pair<std::string, double>> m = {
+        {"ciclos_sem_instrucao", static_cast<double>(c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::SemInstrucao)])},
+        {"ciclos_estacao_ocupada", static_cast<double>(c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::EstacaoOcupada)])},
+        {"ciclos_opcode_desconhecido", static_cast<double>(c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::OpcodeDesconhecido)])},
+        {"ciclos_rob_cheio", static_cast<double>(c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::RobCheio)])},
+    };
+    for (int k = 0; k < NUM_CLASSES_UF; ++k) m.emplace_back(std::string("bloqueios_") + NOMES_CLASSES_UF[k], static_cast<double>(c.bloqueiosPorClasse[k]));
+    for (int k = 0; k < NUM_CLASSES_UF; ++k) m.emplace_back(std::string("ocupacao_media_") + NOMES_CLASSES_UF[k], c.ocupacaoPorClasse[k] / ciclos);
+    m.emplace_back("espera_media_operandos", c.emitidas > 0 ? static_cast<double>(c.esperaOperandos) / c.emitidas : 0.0);
+    m.emplace_back("escritas_cdb", static_cast<double>(c.escritas));
+    m.emplace_back("utilizacao_cdb", c.ciclosComEscrita / ciclos);
+    m.emplace_back("maximo_escritas_ciclo", static_cast<double>(c.maximoEscritasCiclo));
+    m.emplace_back("ciclos_disputa_cdb", static_cast<double>(c.ciclosDisputaCDB));
+    m.emplace_back("espera_cdb", static_cast<double>(c.esperaCDB));
+    m.emplace_back("desvios", static_cast<double>(c.desvios));
+    m.emplace_back("erros_previsao", static_cast<double>(c.errosPrevisao));
+    m.emplace_back("instrucoes_descartadas", static_cast<double>(c.descartadas));
+    if (c.preditor >= 0) {
+        m.emplace_back("acuracia_previsao", c.desvios > 0 ? 1.0 - static_cast<double>(c.errosPrevisao) / c.desvios : 1.0);
+        m.emplace_back("ciclos_penalidade_previsao", static_cast<double>(c.ciclosPenalidade));
+        m.emplace_back("bits_preditor", static_cast<double>(c.bitsPreditor));
+    }
+    if (c.modoLSQ > 0) {
+        m.emplace_back("encaminhamentos_lsq", static_cast<double>(c.encaminhamentos));
+        m.emplace_back("espera_ordem_memoria", static_cast<double>(c.esperaOrdemMemoria));
+        m.emplace_back("reexecucoes_lsq", static_cast<double>(c.reexecucoes));
+    }
+    for (int k = 0; k < NUM_CLASSES_UF; ++k) {
+        if (c.classesComPipeline & (1 << k)) m.emplace_back(std::string("espera_pipeline_") + NOMES_CLASSES_UF[k], static_cast<double>(c.esperaPipeline[k]));
+    }
+    if (c.niveisCache > 0) {
+        m.emplace_back("acessos_l1", static_cast<double>(c.acessosL1));
+        m.emplace_back("taxa_acerto_l1", taxaAcerto(c.acessosL1, c.faltasL1));
+        m.emplace_back("mesclagens_mshr", static_cast<double>(c.mesclagensMSHR));
+        m.emplace_back("espera_mshr", static_cast<double>(c.esperaMSHR));
+        m.emplace_back("despejos_sujos", static_cast<double>(c.despejosSujos));
+        m.emplace_back("latencia_media_falta", c.faltasL1 > 0 ? static_cast<double>(c.somaLatenciaFaltas) / c.faltasL1 : 0.0);
+    }
+    if (c.niveisCache > 1) {
+        m.emplace_back("acessos_l2", static_cast<double>(c.acessosL2));
+        m.emplace_back("taxa_acerto_l2", taxaAcerto(c.acessosL2, c.faltasL2));
+    }
+    return m;
+}
+
+std::vector<std::pair<int64_t, EstatisticaDesvio>> desviosOrdenados(const Contadores& c) { // por pc
+    std::vector<std::pair<int64_t, EstatisticaDesvio>> desvios(c.porDesvio.begin(), c.porDesvio.end());
+    std::sort(desvios.begin(), desvios.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return desvios;
+}
+
+double acuracia(const EstatisticaDesvio& e) { return e.execucoes > 0 ? 1.0 - static_cast<double>(e.erros) / e.execucoes : 1.0; }
+
+void escreveEstatisticas(std::ostream& out, const Contadores& c, const ProgramaDecodificado& programa) { // seção de texto do relatório
+    double ciclos = c.ciclos > 0 ? static_cast<double>(c.ciclos) : 1.0;
+    out << std::fixed << std::setprecision(2);
+    out << "\n== Estatisticas ==\n"
+        << "Ciclos sem emissao: sem instrucao " << c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::SemInstrucao)]
+        << ", estacao ocupada " << c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::EstacaoOcupada)]
+        << ", opcode desconhecido " << c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::OpcodeDesconhecido)]
+        << ", ROB cheio " << c.ciclosPorMotivo[static_cast<int>(MotivoEmissao::RobCheio)] << '\n';
+    out << "Estacao ocupada por classe:";
+    for (int k = 0; k < NUM_CLASSES_UF; ++k) out << (k ? ", " : " ") << NOMES_CLASSES_UF[k] << ' ' << c.bloqueiosPorClasse[k];
+    out << "\nOcupacao media:";
+    for (int k = 0; k < NUM_CLASSES_UF; ++k) {
+        out << (k ? ", " : " ") << NOMES_CLASSES_UF[k] << ' ' << c.ocupacaoPorClasse[k] / ciclos << '/' << c.estacoesPorClasse[k];
+    }
+    out << "\nEspera media por operandos: " << (c.emitidas > 0 ? static_cast<double>(c.esperaOperandos) / c.emitidas : 0.0) << " ciclos por instrucao\n"
+        << "CDB: " << c.escritas << " escritas em " << c.ciclosComEscrita << " ciclos (utilizacao " << 100.0 * c.ciclosComEscrita / ciclos
+        << "%), maximo de " << c.maximoEscritasCiclo << " por ciclo\n"
+        << "Disputa de CDB: " << c.ciclosDisputaCDB << " ciclos, " << c.esperaCDB << " resultados adiados um ciclo\n"
+        << "Desvios: " << c.desvios << " efetivados, " << c.errosPrevisao << " previsoes erradas, " << c.descartadas << " instrucoes descartadas\n";
+    if (c.modoLSQ > 0) {
+        out << "LSQ " << NOMES_MODOS_LSQ[c.modoLSQ] << ": " << c.encaminhamentos << " loads com encaminhamento, " << c.esperaOrdemMemoria
+            << " ciclos de load esperando stores, " << c.reexecucoes << " reexecucoes\n";
+    }
+    if (c.classesComPipeline) {
+        out << "Prontas esperando pipeline:";
+        for (int k = 0, n = 0; k < NUM_CLASSES_UF; ++k) {
+            if (c.classesComPipeline & (1 << k)) out << (n++ ? ", " : " ") << NOMES_CLASSES_UF[k] << ' ' << c.esperaPipeline[k];
+        }
+        out << '\n';
+    }
+    if (c.niveisCache > 0) {
+        out << "Cache L1D: " << c.acessosL1 << " acessos, " << c.faltasL1 << " faltas (acerto " << 100.0 * taxaAcerto(c.acessosL1, c.faltasL1) << "%), "
+            << c.mesclagensMSHR << " mescladas em MSHR, " << c.esperaMSHR << " ciclos esperando MSHR, " << c.despejosSujos << " despejos sujos\n";
+        if (c.niveisCache > 1) {
+            out << "Cache L2: " << c.acessosL2 << " acessos, " << c.faltasL2 << " faltas (acerto " << 100.0 * taxaAcerto(c.acessosL2, c.faltasL2) << "%)\n";
+        }
+        out << "Latencia das faltas: media " << (c.faltasL1 > 0 ? static_cast<double>(c.somaLatenciaFaltas) / c.faltasL1 : 0.0) << " ciclos";
+        for (int k = 0; k < NUM_FAIXAS_LATENCIA; ++k) { // faixas de potência de 2
+            if (c.faltasPorLatencia[k] == 0) continue;
+            int64_t de = k == 0 ? 0 : int64_t(1) << k, ate = (int64_t(1) << (k + 1)) - 1;
+            out << "; " << de << '-' << ate << ": " << c.faltasPorLatencia[k];
+        }
+        out << '\n';
+    }
+    if (c.preditor < 0) return;
+    out << "Preditor: " << NOMES_PREDITORES[c.preditor] << " (" << c.bitsPreditor << " bits), acuracia "
+        << 100.0 * (c.desvios > 0 ? 1.0 - static_cast<double>(c.errosPrevisao) / c.desvios : 1.0) << "%, "
+        << c.ciclosPenalidade << " ciclos de penalidade\n";
+    if (c.porDesvio.empty()) return;
+    out << std::left << std::setw(8) << "Desvio" << std::setw(8) << "Instr" << std::setw(10) << "Alvo" << std::setw(11) << "Execucoes"
+        << std::setw(7) << "Erros" << std::setw(10) << "Acuracia" << "Penalidade" << '\n';
+    for (const auto& d : desviosOrdenados(c)) {
+        std::ostringstream pct;
+        pct << std::fixed << std::setprecision(2) << 100.0 * acuracia(d.second) << '%';
+        out << std::left << std::setw(8) << d.first << std::setw(8) << programa.texto(d.second.op) << std::setw(10) << programa.texto(d.second.rotulo)
+            << std::setw(11) << d.second.execucoes << std::setw(7) << d.second.erros << std::setw(10) << pct.str() << d.second.ciclosPenalidade << '\n';
+    }
+}
+
+void exportaEventosChrome(std::ostream& out, const RegistroEventos& eventos, const Estado& estado) { // formato JSON do Chrome trace/Perfetto: uma fatia por instrução, da emissão à escrita, na linha da sua estação (1 ciclo = 1 us)
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Tomasulo\"}}";
+    for (size_t s = 0; s < estado.estacoes.size(); ++s) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << s << ",\"args\":{\"name\":" << textoJson(estado.estacoes.nome[s]) << "}}"
+            << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << s << ",\"args\":{\"sort_index\":" << s << "}}";
+    }
+    struct Aberta { int64_t posicao = -1, emissao = 0, fimExecucao = -1; };
+    std::vector<Aberta> abertas(estado.estacoes.size()); // uma instrução por estação; eventos sem a emissão (sobrescrita) são descartados
+    auto fatia = [&](const Evento& e, size_t estacao, const Aberta& a, const char* fim) {
+        out << ",\n{\"name\":" << textoJson(estado.programa->texto(e.nome) + " #" + std::to_string(e.posicao)) << ",\"cat\":" << textoJson(estado.programa->texto(e.nome))
+            << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << estacao << ",\"ts\":" << a.emissao << ",\"dur\":" << e.ciclo - a.emissao + 1
+            << ",\"args\":{\"posicao\":" << e.posicao << ",\"issue\":" << a.emissao << ",\"exec\":" << textoCiclo(a.fimExecucao, "null") << ",\"" << fim << "\":" << e.ciclo << "}}";
+    };
+    eventos.percorre([&](const Evento& e) {
+        Aberta& a = abertas[e.estacao];
+        if (e.tipo == TipoEvento::Emissao) {
+            a = {e.posicao, e.ciclo, -1};
+        } else if (e.tipo == TipoEvento::Despacho) { // fecha a fatia na estação e abre outra no estágio, a partir do despacho
+            for (size_t s = 0; s < abertas.size(); ++s) {
+                if (abertas[s].posicao != e.posicao || s == e.estacao) continue;
+                fatia(e, s, abertas[s], "dispatch");
+                abertas[s].posicao = -1;
+                a = {e.posicao, e.ciclo, -1};
+                break;
+            }
+        } else if (a.posicao == e.posicao && e.tipo == TipoEvento::FimExecucao) {
+            a.fimExecucao = e.ciclo;
+        } else if (a.posicao == e.posicao) {
+            fatia(e, e.estacao, a, "write");
+            a.posicao = -1;
+        }
+    });
+    out << "\n]}\n";
+}
+
+bool gravaEventos(const std::string& arquivo, const RegistroEventos& eventos, const Estado& estado) {
+    std::ofstream out(arquivo);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << arquivo << std::endl;
+        return false;
+    }
+    exportaEventosChrome(out, eventos, estado);
+    if (eventos.perdidos() > 0) {
+        std::cerr << "Warning: event buffer full, " << eventos.perdidos() << " oldest events were dropped" << std::endl;
+    }
+    return true;
+}
+
+void escreveRelatorio(std::ostream& out, FormatoRelatorio formato, const ResumoExecucao& resumo, const Contadores* contadores,
+                      std::vector<ResultadoInstrucao>& linhas, const ProgramaDecodificado& programa) { // resumo de fim de execução do modo --quieto
+    std::sort(linhas.begin(), linhas.end(), [](const ResultadoInstrucao& a, const ResultadoInstrucao& b) { return a.posicao < b.posicao; });
+    double ipc = resumo.ciclos > 0 ? static_cast<double>(resumo.instrucoes) / resumo.ciclos : 0.0;
+    bool comCommit = std::any_of(linhas.begin(), linhas.end(), [](const ResultadoInstrucao& l) { return l.commit >= 0; }); // só com ROB
+
+    if (formato == FormatoRelatorio::Texto) {
+        out << "== Resumo da Simulacao ==\n"
+            << "Situacao: " << resumo.situacao << '\n'
+            << "Ciclos: " << resumo.ciclos << '\n'
+            << "Instrucoes concluidas: " << resumo.instrucoes << '\n'
+            << "IPC: " << std::fixed << std::setprecision(4) << ipc << '\n';
+        if (contadores) escreveEstatisticas(out, *contadores, programa);
+        if (linhas.empty()) return;
+        out << "\n== Instrucoes ==\n";
+        out << std::left << std::setw(5) << "#" << std::setw(8) << "Instr" << std::setw(5) << "R" << std::setw(8) << "S" << std::setw(8) << "T"
+            << std::setw(7) << "Issue" << std::setw(7) << "Exec" << std::setw(comCommit ? 7 : 0) << "Write" << (comCommit ? "Commit" : "") << '\n';
+        for (const auto& l : linhas) {
+            out << std::left << std::setw(5) << l.posicao
+                << std::setw(8) << programa.texto(l.texto[0]) << std::setw(5) << programa.texto(l.texto[1])
+                << std::setw(8) << programa.texto(l.texto[2]) << std::setw(8) << programa.texto(l.texto[3])
+                << std::setw(7) << textoCiclo(l.issue, "-") << std::setw(7) << textoCiclo(l.exeCompleta, "-")
+                << std::setw(comCommit ? 7 : 0) << textoCiclo(l.write, "-") << (comCommit ? textoCiclo(l.commit, "-") : "") << '\n';
+        }
+    } else if (formato == FormatoRelatorio::Csv) {
+        out << "situacao,ciclos,instrucoes,ipc\n"
+            << resumo.situacao << ',' << resumo.ciclos << ',' << resumo.instrucoes << ',' << std::fixed << std::setprecision(4) << ipc << '\n';
+        if (contadores) {
+            out << "\nmetrica,valor\n" << std::defaultfloat << std::setprecision(6);
+            for (const auto& m : metricas(*contadores)) out << m.first << ',' << m.second << '\n';
+            if (!contadores->porDesvio.empty()) out << "\ndesvio,instr,alvo,execucoes,erros,acuracia,ciclos_penalidade\n";
+            for (const auto& d : desviosOrdenados(*contadores)) {
+                out << d.first << ',' << programa.texto(d.second.op) << ',' << programa.texto(d.second.rotulo) << ',' << d.second.execucoes << ','
+                    << d.second.erros << ',' << acuracia(d.second) << ',' << d.second.ciclosPenalidade << '\n';
+            }
+        }
+        if (linhas.empty()) return;
+        out << "\nposicao,instr,r,s,t,issue,exec,write" << (comCommit ? ",commit\n" : "\n");
+        for (const auto& l : linhas) {
+            out << l.posicao << ',' << programa.texto(l.texto[0]) << ',' << programa.texto(l.texto[1]) << ','
+                << programa.texto(l.texto[2]) << ',' << programa.texto(l.texto[3]) << ','
+                << textoCiclo(l.issue, "") << ',' << textoCiclo(l.exeCompleta, "") << ',' << textoCiclo(l.write, "");
+            if (comCommit) out << ',' << textoCiclo(l.commit, "");
+            out << '\n';
+        }
+    } else {
+        out << "{\"situacao\":" << textoJson(resumo.situacao) << ",\"ciclos\":" << resumo.ciclos
+            << ",\"instrucoes\":" << resumo.instrucoes << ",\"ipc\":" << std::fixed << std::setprecision(4) << ipc;
+        if (contadores) {
+            out << ",\"estatisticas\":{" << std::defaultfloat << std::setprecision(6);
+            bool primeira = true;
+            for (const auto& m : metricas(*contadores)) {
+                out << (primeira ? "" : ",") << textoJson(m.first) << ':' << m.second;
+                primeira = false;
+            }
+            out << '}';
+            if (!contadores->porDesvio.empty()) {
+                out << ",\"desvios\":[";
+                primeira = true;
+                for (const auto& d : desviosOrdenados(*contadores)) {
+                    out << (primeira ? "\n" : ",\n") << "{\"desvio\":" << d.first << ",\"instr\":" << textoJson(programa.texto(d.second.op))
+                        << ",\"alvo\":" << textoJson(programa.texto(d.second.rotulo)) << ",\"execucoes\":" << d.second.execucoes
+                        << ",\"erros\":" << d.second.erros << ",\"acuracia\":" << acuracia(d.second) << ",\"ciclos_penalidade\":" << d.second.ciclosPenalidade << '}';
+                    primeira = false;
+                }
+                out << ']';
+            }
+        }
+        out << ",\"resultados\":[";
+        for (size_t i = 0; i < linhas.size(); ++i) {
+            const auto& l = linhas[i];
+            out << (i ? ",\n" : "\n") << "{\"posicao\":" << l.posicao << ",\"instr\":" << textoJson(programa.texto(l.texto[0]))
+                << ",\"r\":" << textoJson(programa.texto(l.texto[1])) << ",\"s\":" << textoJson(programa.texto(l.texto[2]))
+                << ",\"t\":" << textoJson(programa.texto(l.texto[3])) << ",\"issue\":" << textoCiclo(l.issue, "null")
+                << ",\"exec\":" << textoCiclo(l.exeCompleta, "null") << ",\"write\":" << textoCiclo(l.write, "null");
+            if (comCommit) out << ",\"commit\":" << textoCiclo(l.commit, "null");
+            out << '}';
+        }
+        out << "]}\n";
+    }
+}
+
+std::unique_ptr<Estado> carregaSimulador(const std::string& filename, bool streaming, ConfigSimulador& config) { // lê o trace (texto ou binário) e cria o simulador
+    if (TraceBinario::ehTraceBinario(filename)) {
+        auto trace = std::make_shared<TraceBinario>();
+        if (!trace->abre(filename, config)) {
+            return nullptr;
+        }
+        auto programa = trace->programa;
+        if (streaming) {
+            return std::make_unique<Estado>(config, programa, std::make_unique<FonteBinaria>(trace));
+        }
+        programa->instrucoes.reserve(trace->numInstrucoes);
+        for (uint64_t i = 0; i < trace->numInstrucoes; ++i) {
+            programa->instrucoes.push_back(trace->instrucao(i));
+        }
+        return std::make_unique<Estado>(config, programa);
+    }
+    if (streaming) {
+        auto fonte = std::make_unique<FonteArquivo>();
+        if (!fonte->abre(filename, config)) {
+            return nullptr;
+        }
+        if (config.tamanhoROB == 0) {
+            auto programa = fonte->programa;
+            return std::make_unique<Estado>(config, programa, std::move(fonte));
+        }
+        std::cerr << "Warning: ROB_SIZE needs random access to follow branches; loading the whole text trace (use a binary trace to stream)" << std::endl;
+    }
+    std::vector<InstrucaoInput> instructions;
+    std::string rotuloNoFim;
+    if (!parseInputFile(filename, config, instructions, rotuloNoFim)) {
+        return nullptr;
+    }
+    auto programa = std::make_shared<ProgramaDecodificado>();
+    decodificaPrograma(config, instructions, rotuloNoFim, *programa);
+    return std::make_unique<Estado>(config, programa);
+}
+
+int64_t proximoSnapshot(int64_t clock, int64_t aCada, const std::vector<int64_t>& ciclos) { // próximo ciclo > clock com snapshot pedido, 0 se nenhum
+    int64_t proximo = aCada > 0 ? (clock / aCada + 1) * aCada : 0;
+    auto it = std::upper_bound(ciclos.begin(), ciclos.end(), clock);
+    if (it != ciclos.end() && (proximo == 0 || *it < proximo)) proximo = *it;
+    return proximo;
+}
+
+// roda sem interação, pulando ciclos ociosos; retorna a situação final. Com ate_concluir, também para (como "limite")
+// no ciclo em que as instruções concluídas chegam a esse total
+std::string executaEmLote(Estado& simulador, long long cycle_limit, int64_t snapshot_a_cada = 0, const std::vector<int64_t>& snapshots_em = {},
+                          int64_t ate_concluir = 0) {
+    if (simulador.vazio()) return "concluida"; // restaurado ou avançado depois do fim
+    while (cycle_limit == 0 || simulador.clock_cycle < cycle_limit) {
+        int ociosos = simulador.ciclosOciosos();
+        if (ociosos < 0) return "travada";
+        if (cycle_limit > 0) ociosos = static_cast<int>(std::min<long long>(ociosos, cycle_limit - simulador.clock_cycle - 1));
+        int64_t snapshot = proximoSnapshot(simulador.clock_cycle, snapshot_a_cada, snapshots_em);
+        if (snapshot > 0 && snapshot <= simulador.clock_cycle + ociosos) {
+            simulador.saltaCiclos(static_cast<int>(snapshot - simulador.clock_cycle));
+            simulador.printEstadoDebug();
+            continue;
+        }
+        simulador.saltaCiclos(ociosos);
+        bool terminou = simulador.executa_ciclo();
+        if (simulador.clock_cycle == snapshot) simulador.printEstadoDebug();
+        if (terminou) return "concluida";
+        if (ate_concluir > 0 && simulador.instrucoesConcluidas() >= ate_concluir) return "limite";
+    }
+    return "limite";
+}
+
+struct FaixaVarredura { // um parâmetro variado na varredura, ex.: "UNITS Add 1:4", "CYCLES Mult 2:10:2", "MEM_UNITS Load 2,4,8" ou "ROB_SIZE 8,16,32"
+    std::string secao;
+    std::string nome;
+    std::vector<int> valores;
+};
+
+bool parseFaixa(const std::string& texto, FaixaVarredura& out) {
+    std::stringstream ss(texto);
+    std::string valores;
+    ss >> out.secao;
+    const ParametroEscalar* escalar = buscaParametroEscalar(out.secao);
+    if (!escalar) ss >> out.nome;
+    if (!(ss >> valores) || (!escalar && out.secao != "CYCLES" && out.secao != "UNITS" && out.secao != "MEM_UNITS")) {
+        std::cerr << "Error: Invalid sweep range '" << texto << "' (expected CYCLES|UNITS|MEM_UNITS <nome> <valores> or <PARAMETRO> <valores>"
+                  << " for a single-valued config keyword such as ISSUE_WIDTH or PREDICTOR, with <valores> = inicio:fim[:passo] or v1,v2,...)" << std::endl;
+        return false;
+    }
+    if (valores.find(':') != std::string::npos) {
+        int inicio = 0, fim = 0, passo = 1;
+        char sep;
+        std::stringstream sv(valores);
+        sv >> inicio >> sep >> fim;
+        if (sv >> sep) sv >> passo;
+        if (passo <= 0) passo = 1;
+        for (int v = inicio; v <= fim; v += passo) out.valores.push_back(v);
+    } else {
+        std::stringstream sv(valores);
+        std::string v;
+        while (std::getline(sv, v, ',')) {
+            int valor = std::atoi(v.c_str());
+            if (escalar && !leValorParametro(*escalar, v, valor)) {
+                std::cerr << "Error: Invalid value '" << v << "' for " << out.secao << std::endl;
+                return false;
+            }
+            out.valores.push_back(valor);
+        }
+    }
+    if (out.valores.empty()) {
+        std::cerr << "Error: Empty sweep range '" << texto << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+class PoolTrabalho { // work stealing: cada thread consome sua fila pelo fim e, sem trabalho, rouba do início das filas das outras
+public:
+    explicit PoolTrabalho(unsigned numThreads) : filas(numThreads > 0 ? numThreads : 1) {}
+
+    void executa(size_t numTarefas, const std::function<void(size_t)>& tarefa) {
+        for (size_t t = 0; t < numTarefas; ++t) filas[t % filas.size()].tarefas.push_back(t);
+        std::vector<std::thread> threads;
+        for (size_t dono = 0; dono < filas.size(); ++dono) {
+            threads.emplace_back([this, dono, &tarefa] {
+                size_t t;
+                while (pega(dono, t)) tarefa(t);
+            });
+        }
+        for (auto& th : threads) th.join();
+    }
+
+private:
+    struct Fila {
+        std::mutex trava;
+        std::deque<size_t> tarefas;
+    };
+    std::vector<Fila> filas;
+
+    bool pega(size_t dono, size_t& tarefa) { // as tarefas não geram novas tarefas: se todas as filas estão vazias, acabou
+        {
+            std::lock_guard<std::mutex> g(filas[dono].trava);
+            if (!filas[dono].tarefas.empty()) {
+                tarefa = filas[dono].tarefas.back();
+                filas[dono].tarefas.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < filas.size(); ++k) {
+            Fila& vitima = filas[(dono + k) % filas.size()];
+            std::lock_guard<std::mutex> g(vitima.trava);
+            if (!vitima.tarefas.empty()) {
+                tarefa = vitima.tarefas.front();
+                vitima.tarefas.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+void escreveVarredura(std::ostream& out, FormatoRelatorio formato, const std::vector<FaixaVarredura>& faixas, const std::vector<std::vector<int>>& valores,
+                      const std::vector<ResumoExecucao>& resumos) { // uma linha por configuração, na ordem do produto cartesiano das faixas
+    std::vector<std::string> colunas;
+    for (const auto& f : faixas) colunas.push_back(f.nome.empty() ? f.secao : f.secao + " " + f.nome);
+    auto textoValor = [&](size_t k, int v) { // nome, para parâmetros simbólicos como PREDICTOR
+        const ParametroEscalar* p = buscaParametroEscalar(faixas[k].secao);
+        return p ? textoParametro(*p, v) : std::to_string(v);
+    };
+    auto ipc = [](const ResumoExecucao& r) { return r.ciclos > 0 ? static_cast<double>(r.instrucoes) / r.ciclos : 0.0; };
+    out << std::fixed << std::setprecision(4);
+
+    if (formato == FormatoRelatorio::Texto) {
+        for (const auto& c : colunas) out << std::left << std::setw(std::max<int>(c.size() + 2, 8)) << c;
+        out << std::setw(11) << "Situacao" << std::setw(12) << "Ciclos" << std::setw(12) << "Instrucoes" << "IPC" << '\n';
+        for (size_t i = 0; i < resumos.size(); ++i) {
+            for (size_t k = 0; k < colunas.size(); ++k) out << std::left << std::setw(std::max<int>(colunas[k].size() + 2, 8)) << textoValor(k, valores[i][k]);
+            out << std::setw(11) << resumos[i].situacao << std::setw(12) << resumos[i].ciclos << std::setw(12) << resumos[i].instrucoes << ipc(resumos[i]) << '\n';
+        }
+    } else if (formato == FormatoRelatorio::Csv) {
+        for (const auto& c : colunas) out << c << ',';
+        out << "situacao,ciclos,instrucoes,ipc\n";
+        for (size_t i = 0; i < resumos.size(); ++i) {
+            for (size_t k = 0; k < colunas.size(); ++k) out << textoValor(k, valores[i][k]) << ',';
+            out << resumos[i].situacao << ',' << resumos[i].ciclos << ',' << resumos[i].instrucoes << ',' << ipc(resumos[i]) << '\n';
+        }
+    } else {
+        out << '[';
+        for (size_t i = 0; i < resumos.size(); ++i) {
+            out << (i ? ",\n" : "\n") << '{';
+            for (size_t k = 0; k < colunas.size(); ++k) {
+                const ParametroEscalar* p = buscaParametroEscalar(faixas[k].secao);
+                out << textoJson(colunas[k]) << ':' << (p && p->nomes ? textoJson(textoValor(k, valores[i][k])) : std::to_string(valores[i][k])) << ',';
+            }
+            out << "\"situacao\":" << textoJson(resumos[i].situacao) << ",\"ciclos\":" << resumos[i].ciclos
+                << ",\"instrucoes\":" << resumos[i].instrucoes << ",\"ipc\":" << ipc(resumos[i]) << '}';
+        }
+        out << "]\n";
+    }
+}
+
+struct TraceCompartilhado { // trace lido e decodificado uma vez, somente leitura, para vários simuladores (em threads diferentes)
+    ConfigSimulador config;
+    std::shared_ptr<const TraceBinario> binario; // nulo para um trace de texto, carregado em programa
+    std::shared_ptr<const ProgramaDecodificado> programa;
+
+    bool abre(const std::string& filename) {
+        if (TraceBinario::ehTraceBinario(filename)) {
+            auto t = std::make_shared<TraceBinario>();
+            if (!t->abre(filename, config)) return false;
+            binario = t;
+            programa = t->programa;
+            return true;
+        }
+        std::vector<InstrucaoInput> instructions;
+        std::string rotuloNoFim;
+        if (!parseInputFile(filename, config, instructions, rotuloNoFim)) return false;
+        auto p = std::make_shared<ProgramaDecodificado>();
+        decodificaPrograma(config, instructions, rotuloNoFim, *p);
+        programa = p;
+        return true;
+    }
+
+    int64_t numInstrucoes() const { return binario ? static_cast<int64_t>(binario->numInstrucoes) : static_cast<int64_t>(programa->instrucoes.size()); }
+
+    InstrucaoDecodificada instrucao(int64_t i) const {
+        return binario ? binario->instrucao(static_cast<uint64_t>(i)) : programa->instrucoes[static_cast<size_t>(i)];
+    }
+
+    std::unique_ptr<FonteInstrucoes> criaFonte() const {
+        if (binario) return std::make_unique<FonteBinaria>(binario);
+        return std::make_unique<FontePrograma>(programa);
+    }
+
+    std::unique_ptr<Estado> criaSimulador(const ConfigSimulador& c) const { return std::make_unique<Estado>(c, programa, criaFonte()); }
+};
+
+// varredura em lockstep: LANES_LOTE configurações do mesmo trace avançam juntas, ciclo a ciclo, uma por lane.
+// As estações de todas as lanes (a união dos nomes, na ordem de criaEstacoes) guardam cada campo num vetor com um
+// inteiro por lane (extensão vector_size do GCC/Clang): contagem de tempo, teste de prontidão, casamento de tags na
+// escrita e busca de ciclos ociosos são uma operação por estação para o lote todo. A largura segue o -march: 16
+// lanes com AVX-512, 8 com AVX2 e 4 com SSE/NEON, ou em código escalar sem SIMD. Emissão e registradores seguem
+// lane a lane. Cobre o modelo sem ROB, LSQ, PIPES, CDB_COUNT e cache, em que as configurações diferem em latências,
+// unidades e ISSUE_WIDTH; o resultado de cada lane é o mesmo de um Estado com a sua configuração
+#if defined(__AVX512F__)
+constexpr int LANES_LOTE = 16;
+#elif defined(__AVX2__)
+constexpr int LANES_LOTE = 8;
+#else
+constexpr int LANES_LOTE = 4;
+#endif
+typedef int32_t VetorLanes __attribute__((vector_size(LANES_LOTE * sizeof(int32_t)))); // comparações dão -1 (verdadeiro) ou 0
+
+uint32_t lanesMarcadas(const VetorLanes& mascara) { // bit l: lane l verdadeira
+    uint32_t r = 0;
+    for (int l = 0; l < LANES_LOTE; ++l) r |= static_cast<uint32_t>(mascara[l] & 1) << l;
+    return r;
+}
+
+class MotorLockstep {
+public:
+    static bool suporta(const ConfigSimulador& c) { // o resto fica com o Estado
+        if (c.tamanhoROB > 0 || c.modoLSQ || c.numCDBs > 0 || !c.pipelines.empty() || (c.tamanhoL1 > 0 && c.funcional)) return false;
+        for (const auto& p : c.ciclos) {
+            if (p.second < 0) return false; // latência negativa: a estação nunca termina e o Estado nunca trava
+        }
+        return true;
+    }
+
+    MotorLockstep(const TraceCompartilhado& trace, const std::vector<const ConfigSimulador*>& configs)
+        : trace(trace), numLanes(static_cast<int>(configs.size())) {
+        numInstrucoes = trace.numInstrucoes();
+        for (int l = 0; l < LANES_LOTE; ++l) {
+            for (int c = 0; c < NUM_CLASSES_UF; ++c) latencias[c][l] = 1;
+            largura[l] = 0;
+            proxima[l] = 0;
+            emVoo[l] = 0;
+            concluidas[l] = 0;
+            instrucao[l] = nullptr;
+        }
+        for (int l = 0; l < numLanes; ++l) {
+            for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+                auto it = configs[l]->ciclos.find(NOMES_CLASSES_UF[c]);
+                if (it != configs[l]->ciclos.end()) latencias[c][l] = it->second;
+            }
+            largura[l] = configs[l]->larguraEmissao;
+            busca(l);
+        }
+        criaEstacoes(configs, &ConfigSimulador::unidades);
+        numAritmeticas = estacoes.size();
+        criaEstacoes(configs, &ConfigSimulador::unidadesMem);
+        consumidoras.assign(estacoes.size(), {});
+        tag.assign(trace.programa->nomeRegistrador.size(), std::array<int32_t, LANES_LOTE>());
+        for (auto& t : tag) t.fill(-1);
+        ociosos = VetorLanes{} + INT32_MAX;
+    }
+
+    void executa(long long cycle_limit, std::vector<ResumoExecucao>& resumos) { // resumos[l]: como executaEmLote num Estado com a configuração da lane l
+        resumos.assign(numLanes, ResumoExecucao());
+        std::vector<int> rodando(numLanes);
+        std::iota(rodando.begin(), rodando.end(), 0);
+        int64_t clock = 0;
+        auto encerra = [&](const char* situacao) { // tira de rodando as lanes marcadas em fim
+            size_t n = 0;
+            for (int l : rodando) {
+                if (fim[l]) resumos[l] = {situacao, clock, concluidas[l]};
+                else rodando[n++] = l;
+            }
+            rodando.resize(n);
+        };
+        while (!rodando.empty()) {
+            if (cycle_limit > 0 && clock >= cycle_limit) {
+                for (int l : rodando) resumos[l] = {"limite", clock, concluidas[l]};
+                break;
+            }
+            int64_t salto = INT64_MAX; // ciclos ociosos comuns a todas as lanes ainda rodando
+            bool travou = false;
+            calculaLivres();
+            for (int l : rodando) {
+                livre[l] = proxima[l] < numInstrucoes ? primeiraLivre[chave[l]][l] : -1;
+                int32_t ate = livre[l] >= 0 ? 0 : ociosos[l];
+                fim[l] = ate == INT32_MAX;
+                travou |= fim[l];
+                salto = std::min<int64_t>(salto, ate);
+            }
+            if (travou) encerra("travada");
+            if (rodando.empty()) break;
+            if (cycle_limit > 0) salto = std::min<int64_t>(salto, cycle_limit - clock - 1);
+            if (salto > 0) {
+                saltaCiclos(static_cast<int32_t>(salto));
+                clock += salto;
+            }
+            clock++;
+            for (int l : rodando) {
+                if (livre[l] >= 0) emite(l);
+            }
+            executaEstacoes();
+            escreve();
+            bool concluiu = false;
+            for (int l : rodando) {
+                fim[l] = proxima[l] == numInstrucoes && emVoo[l] == 0;
+                concluiu |= fim[l];
+            }
+            if (concluiu) encerra("concluida");
+        }
+    }
+
+private:
+    struct EstacaoLanes { // uma estação em todas as lanes; existe é máscara (-1); q1, q2 e destino usam -1 para nenhum
+        VetorLanes existe, ocupado, tempo, q1, q2, destino, escrita;
+        uint32_t escritas = 0; // lanes que escrevem neste ciclo
+    };
+
+    const TraceCompartilhado& trace;
+    int numLanes;
+    int64_t numInstrucoes = 0;
+    size_t numAritmeticas = 0; // [0, numAritmeticas): aritméticas/inteiro; depois, buffers de memória
+    std::vector<EstacaoLanes> estacoes;
+    std::vector<std::vector<int32_t>> consumidoras; // por produtora: estações que esperam por ela em alguma lane, como em Estado
+    std::vector<int32_t> porClasse[2 * NUM_CLASSES_UF]; // estações de cada classe, aritméticas e depois de memória, na ordem de busca
+    VetorLanes primeiraLivre[2 * NUM_CLASSES_UF];       // por lista de porClasse: primeira estação livre em cada lane, -1 se nenhuma
+    std::vector<std::array<int32_t, LANES_LOTE>> tag; // por registrador: estação produtora pendente
+    std::array<int32_t, LANES_LOTE> latencias[NUM_CLASSES_UF];
+    std::array<int32_t, LANES_LOTE> largura, livre; // livre: estação para a próxima instrução, achada no início do ciclo
+    std::array<int32_t, LANES_LOTE> chave;          // lista de porClasse da próxima instrução
+    std::array<bool, LANES_LOTE> fim;
+    VetorLanes ociosos; // Estado::ciclosOciosos sem a emissão, calculado no fim do ciclo; INT32_MAX se nenhuma estação pode avançar
+    std::array<int64_t, LANES_LOTE> proxima, emVoo, concluidas;
+    std::array<const InstrucaoDecodificada*, LANES_LOTE> instrucao; // próxima a emitir: no programa ou, num trace binário, em decodificada
+    std::array<InstrucaoDecodificada, LANES_LOTE> decodificada;
+
+    void busca(int l) {
+        if (proxima[l] >= numInstrucoes) return;
+        if (!trace.binario) {
+            instrucao[l] = &trace.programa->instrucoes[proxima[l]];
+            chave[l] = lista(*instrucao[l]);
+            return;
+        }
+        decodificada[l] = trace.binario->instrucao(static_cast<uint64_t>(proxima[l]));
+        instrucao[l] = &decodificada[l];
+        chave[l] = lista(decodificada[l]);
+    }
+
+    static int lista(const InstrucaoDecodificada& d) { return d.memoria() * NUM_CLASSES_UF + static_cast<int>(d.classe); }
+
+    void criaEstacoes(const std::vector<const ConfigSimulador*>& configs, std::map<std::string, int> ConfigSimulador::*secao) {
+        std::map<std::string, int> maximo; // a lane l tem as primeiras (*secao)[tipo] estações de cada tipo
+        for (const ConfigSimulador* c : configs) {
+            for (const auto& pair : c->*secao) maximo[pair.first] = std::max(maximo[pair.first], pair.second);
+        }
+        std::vector<std::pair<std::pair<std::string, std::string>, int>> criadas; // ((nome, tipo), índice): a ordem de criaEstacoes
+        for (const auto& pair : maximo) {
+            for (int i = 0; i < pair.second; ++i) criadas.push_back({{pair.first + std::to_string(i + 1), pair.first}, i});
+        }
+        std::sort(criadas.begin(), criadas.end());
+        int grupo = secao == &ConfigSimulador::unidadesMem ? NUM_CLASSES_UF : 0;
+        for (const auto& c : criadas) {
+            EstacaoLanes e;
+            e.existe = e.ocupado = e.tempo = e.escrita = VetorLanes{};
+            e.q1 = e.q2 = e.destino = VetorLanes{} - 1;
+            for (int l = 0; l < numLanes; ++l) {
+                auto it = (configs[l]->*secao).find(c.first.second);
+                e.existe[l] = it != (configs[l]->*secao).end() && c.second < it->second ? -1 : 0;
+            }
+            ClasseUF k = classePorNome(c.first.second);
+            if (k != ClasseUF::Nenhuma) porClasse[grupo + static_cast<int>(k)].push_back(static_cast<int32_t>(estacoes.size()));
+            estacoes.push_back(e);
+        }
+    }
+
+    int estacaoLivre(int l, const InstrucaoDecodificada& d) const {
+        for (int32_t s : porClasse[lista(d)]) {
+            if (estacoes[s].existe[l] && !estacoes[s].ocupado[l]) return s;
+        }
+        return -1;
+    }
+
+    void calculaLivres() {
+        for (int k = 0; k < 2 * NUM_CLASSES_UF; ++k) {
+            VetorLanes primeira = VetorLanes{} - 1;
+            for (size_t i = porClasse[k].size(); i-- > 0;) {
+                const EstacaoLanes& e = estacoes[porClasse[k][i]];
+                VetorLanes livre = e.existe & (e.ocupado == 0);
+                primeira = (livre & porClasse[k][i]) | (~livre & primeira);
+            }
+            primeiraLivre[k] = primeira;
+        }
+    }
+
+    void saltaCiclos(int32_t n) {
+        for (EstacaoLanes& e : estacoes) {
+            VetorLanes conta = (e.ocupado != 0) & (e.q1 < 0) & (e.q2 < 0) & (e.tempo > 0);
+            e.tempo -= conta & n;
+        }
+    }
+
+    void emite(int l) { // alocaFU/alocaFuMem e escreveEstacaoRegistrador, até ISSUE_WIDTH instruções em ordem
+        for (int emitidas = 0; emitidas < largura[l]; ++emitidas) {
+            int s = emitidas == 0 ? livre[l] : (proxima[l] < numInstrucoes ? estacaoLivre(l, *instrucao[l]) : -1);
+            if (s < 0) return;
+            const InstrucaoDecodificada& d = *instrucao[l];
+            EstacaoLanes& e = estacoes[s];
+            int32_t t = latencias[static_cast<int>(d.classe)][l] + 1;
+            if ((d.flags & CONTA_NA_EMISSAO) && t > 0) t--;
+            e.ocupado[l] = 1;
+            e.tempo[l] = t;
+            if (d.memoria()) {
+                e.q1[l] = (d.flags & ARMAZENA) ? produtora(d.fonteJ.registrador, l) : -1;
+                e.q2[l] = produtora(d.fonteK.registrador, l);
+            } else {
+                e.q1[l] = d.fonteJ.nome != SEM_ID ? produtora(d.fonteJ.registrador, l) : -1;
+                e.q2[l] = d.fonteK.nome != SEM_ID ? produtora(d.fonteK.registrador, l) : -1;
+            }
+            uint32_t outras = ~(uint32_t(1) << l);
+            for (int32_t q : {e.q1[l], e.q2[l]}) {
+                if (q < 0 || (lanesMarcadas((e.q1 == q) | (e.q2 == q)) & outras)) continue; // já na lista, por outra lane
+                if (consumidoras[q].empty() || consumidoras[q].back() != s) consumidoras[q].push_back(s);
+            }
+            e.destino[l] = d.destino;
+            if (d.destino >= 0) tag[d.destino][l] = s;
+            emVoo[l]++;
+            proxima[l]++;
+            busca(l);
+        }
+    }
+
+    int32_t produtora(int32_t r, int l) const { return r >= 0 ? tag[r][l] : -1; }
+
+    void executaEstacoes() { // marca as que escrevem neste ciclo (terminaram num ciclo anterior) e conta o tempo das prontas
+        for (EstacaoLanes& e : estacoes) {
+            VetorLanes pronta = (e.ocupado != 0) & (e.q1 < 0) & (e.q2 < 0);
+            e.escrita = pronta & (e.tempo == -1);
+            e.tempo += pronta & (e.tempo > 0); // máscara -1: decrementa
+            e.tempo |= pronta & (e.tempo == 0);
+            e.escritas = lanesMarcadas(e.escrita);
+        }
+    }
+
+    // sem limite de CDBs a ordem das escritas de um ciclo não muda o resultado: cada produtora libera só as suas
+    // vagas, com as regras de liberaUFEsperandoResultado (aritmética conta um ciclo quando Qj e Qk ficam livres;
+    // buffer de memória conta um por operando liberado e, esperando as duas fontes da mesma produtora, libera só Qi
+    // nesta escrita), e o registrador só volta a ter valor se ainda apontar para ela
+    void escreve() {
+        for (size_t s = 0; s < estacoes.size(); ++s) {
+            EstacaoLanes& p = estacoes[s];
+            if (!p.escritas) continue;
+            for (uint32_t resto = p.escritas; resto; resto &= resto - 1) {
+                int l = __builtin_ctz(resto);
+                int32_t r = p.destino[l];
+                if (r >= 0 && tag[r][l] == static_cast<int32_t>(s)) tag[r][l] = -1;
+                emVoo[l]--;
+                concluidas[l]++;
+            }
+            p.ocupado &= ~p.escrita;
+            VetorLanes escrita = p.escrita;
+            int32_t produtora = static_cast<int32_t>(s);
+            std::vector<int32_t>& lista = consumidoras[s];
+            size_t restantes = 0;
+            for (int32_t c : lista) {
+                EstacaoLanes& e = estacoes[c];
+                VetorLanes libera1 = escrita & (e.q1 == produtora);
+                VetorLanes libera2 = escrita & (e.q2 == produtora);
+                e.q1 |= libera1;
+                if (static_cast<size_t>(c) >= numAritmeticas) {
+                    libera2 &= ~libera1;
+                    e.q2 |= libera2;
+                    e.tempo += libera1 & (e.tempo > 0);
+                    e.tempo += libera2 & (e.tempo > 0);
+                } else {
+                    e.q2 |= libera2;
+                    e.tempo += (libera1 | libera2) & (e.q1 < 0) & (e.q2 < 0) & (e.tempo > 0);
+                }
+                if (lanesMarcadas((e.q1 == produtora) | (e.q2 == produtora))) lista[restantes++] = c; // ainda espera em outra lane
+            }
+            lista.resize(restantes);
+        }
+        VetorLanes ate = VetorLanes{} + INT32_MAX;
+        for (EstacaoLanes& e : estacoes) {
+            VetorLanes pronta = (e.ocupado != 0) & (e.q1 < 0) & (e.q2 < 0); // tempo -1 (escrita no próximo ciclo) dá 0
+            VetorLanes t = e.tempo - 1;
+            t &= t > 0;
+            t = (pronta & t) | (~pronta & INT32_MAX);
+            VetorLanes menor = t < ate;
+            ate = (menor & t) | (~menor & ate);
+        }
+        ociosos = ate;
+    }
+};
+
+// núcleos especializados: as máquinas que as varreduras mais revisitam têm unidades, latências e ISSUE_WIDTH fixos
+// em tempo de compilação. Com o número de estações constante, as estações são std::array, as faixas de cada classe
+// e os laços de escrita têm limites conhecidos pelo compilador (que os desenrola) e a latência de cada classe é uma
+// constante. Cobre o mesmo modelo do MotorLockstep; as demais configurações ficam com o Estado
+struct FormaInput { // input.txt
+    static constexpr const char* nome = "input";
+    static constexpr std::array<int, NUM_CLASSES_UF> unidades = {1, 2, 1, 1, 0, 0}; // Add, Mult, Div, Integer, Load, Store
+    static constexpr std::array<int, NUM_CLASSES_UF> unidadesMem = {0, 0, 0, 0, 2, 1};
+    static constexpr std::array<int, NUM_CLASSES_UF> latencias = {2, 4, 10, 1, 2, 2};
+    static constexpr int largura = 1;
+};
+
+struct FormaInput2 { // input2.txt, também a configuração padrão de --gera e --benchmark
+    static constexpr const char* nome = "input2";
+    static constexpr std::array<int, NUM_CLASSES_UF> unidades = {3, 2, 1, 3, 0, 0};
+    static constexpr std::array<int, NUM_CLASSES_UF> unidadesMem = {0, 0, 0, 0, 6, 3};
+    static constexpr std::array<int, NUM_CLASSES_UF> latencias = {2, 10, 40, 1, 2, 2};
+    static constexpr int largura = 1;
+};
+
+template <class Forma>
+class NucleoFixo {
+public:
+    static bool casa(const ConfigSimulador& c) { // a configuração é exatamente a da forma
+        if (!MotorLockstep::suporta(c) || c.larguraEmissao != Forma::largura) return false;
+        std::array<int, 2 * NUM_CLASSES_UF> contagem{};
+        for (const auto& pair : c.unidades) {
+            ClasseUF k = classePorNome(pair.first);
+            if (k != ClasseUF::Nenhuma) contagem[static_cast<int>(k)] += std::max(pair.second, 0);
+        }
+        for (const auto& pair : c.unidadesMem) {
+            ClasseUF k = classePorNome(pair.first);
+            if (k != ClasseUF::Nenhuma) contagem[NUM_CLASSES_UF + static_cast<int>(k)] += std::max(pair.second, 0);
+        }
+        for (int k = 0; k < 2 * NUM_CLASSES_UF; ++k) {
+            if (contagem[k] != INICIO[k + 1] - INICIO[k]) return false;
+        }
+        for (int k = 0; k < NUM_CLASSES_UF; ++k) {
+            auto it = c.ciclos.find(NOMES_CLASSES_UF[k]);
+            if ((it != c.ciclos.end() ? it->second : 1) != Forma::latencias[k]) return false;
+        }
+        return true;
+    }
+
+    static ResumoExecucao executa(FonteInstrucoes& fonte, size_t numRegistradores, long long cycle_limit) {
+        NucleoFixo nucleo(fonte, numRegistradores);
+        return nucleo.roda(cycle_limit);
+    }
+
+private:
+    static constexpr std::array<int, 2 * NUM_CLASSES_UF + 1> calculaInicio() {
+        std::array<int, 2 * NUM_CLASSES_UF + 1> r{};
+        for (int k = 0; k < 2 * NUM_CLASSES_UF; ++k) r[k + 1] = r[k] + (k < NUM_CLASSES_UF ? Forma::unidades[k] : Forma::unidadesMem[k - NUM_CLASSES_UF]);
+        return r;
+    }
+    static constexpr std::array<int, 2 * NUM_CLASSES_UF + 1> INICIO = calculaInicio(); // estações da lista k: [INICIO[k], INICIO[k + 1])
+    static constexpr int NUM_ESTACOES = INICIO[2 * NUM_CLASSES_UF];
+    static constexpr int NUM_ARITMETICAS = INICIO[NUM_CLASSES_UF];
+    static_assert(NUM_ESTACOES <= 64, "esperando guarda as consumidoras numa palavra de 64 bits");
+
+    FonteInstrucoes& fonte;
+    std::array<int32_t, NUM_ESTACOES> ocupado{}, tempo{}, q1, q2, destino; // ocupado: 0 ou 1
+    std::array<uint64_t, NUM_ESTACOES> esperando{};                        // por produtora: bit c se a estação c espera por ela
+    std::vector<int32_t> tag; // por registrador: estação produtora pendente, -1 se nenhuma
+    InstrucaoDecodificada atual;
+    bool temProxima = false;
+    int chave = 0;
+    int32_t ociosos = INT32_MAX;
+    int64_t emVoo = 0, concluidas = 0;
+
+    NucleoFixo(FonteInstrucoes& fonte, size_t numRegistradores) : fonte(fonte), tag(numRegistradores, -1) {
+        q1.fill(-1);
+        q2.fill(-1);
+        destino.fill(-1);
+        busca();
+    }
+
+    ResumoExecucao roda(long long cycle_limit) { // como MotorLockstep::executa com uma lane
+        int64_t clock = 0;
+        while (true) {
+            if (cycle_limit > 0 && clock >= cycle_limit) return {"limite", clock, concluidas};
+            int livre = temProxima ? estacaoLivre(chave) : -1;
+            int32_t salto = livre >= 0 ? 0 : ociosos;
+            if (salto == INT32_MAX) return {"travada", clock, concluidas};
+            if (cycle_limit > 0) salto = static_cast<int32_t>(std::min<int64_t>(salto, cycle_limit - clock - 1));
+            if (salto > 0) {
+                for (int s = 0; s < NUM_ESTACOES; ++s) tempo[s] -= salto & -(pronta(s) & (tempo[s] > 0));
+                clock += salto;
+            }
+            clock++;
+            if (livre >= 0) emite(livre);
+            executaEstacoes();
+            if (!temProxima && emVoo == 0) return {"concluida", clock, concluidas};
+        }
+    }
+
+    void busca() {
+        temProxima = fonte.proxima(atual);
+        if (!temProxima) return;
+        chave = atual.memoria() * NUM_CLASSES_UF + static_cast<int>(atual.classe);
+        int32_t maior = std::max({atual.destino, atual.fonteJ.registrador, atual.fonteK.registrador});
+        if (maior >= static_cast<int32_t>(tag.size())) tag.resize(maior + 1, -1); // fonte sob demanda: a tabela de registradores cresce
+    }
+
+    int estacaoLivre(int k) const {
+        for (int s = INICIO[k]; s < INICIO[k + 1]; ++s) {
+            if (!ocupado[s]) return s;
+        }
+        return -1;
+    }
+
+    int32_t pronta(int s) const { return ocupado[s] & (q1[s] < 0) & (q2[s] < 0); }
+
+    int32_t produtora(int32_t r) const { return r >= 0 ? tag[r] : -1; }
+
+    void emite(int s) { // alocaFU/alocaFuMem e escreveEstacaoRegistrador, até ISSUE_WIDTH instruções em ordem
+        for (int emitidas = 0; emitidas < Forma::largura; ++emitidas) {
+            if (emitidas > 0) s = temProxima ? estacaoLivre(chave) : -1;
+            if (s < 0) return;
+            const InstrucaoDecodificada& d = atual;
+            int32_t t = Forma::latencias[static_cast<int>(d.classe)] + 1;
+            if (d.flags & CONTA_NA_EMISSAO) t--; // latências da forma são positivas
+            ocupado[s] = 1;
+            tempo[s] = t;
+            if (d.memoria()) {
+                q1[s] = (d.flags & ARMAZENA) ? produtora(d.fonteJ.registrador) : -1;
+                q2[s] = produtora(d.fonteK.registrador);
+            } else {
+                q1[s] = d.fonteJ.nome != SEM_ID ? produtora(d.fonteJ.registrador) : -1;
+                q2[s] = d.fonteK.nome != SEM_ID ? produtora(d.fonteK.registrador) : -1;
+            }
+            if (q1[s] >= 0) esperando[q1[s]] |= uint64_t(1) << s;
+            if (q2[s] >= 0) esperando[q2[s]] |= uint64_t(1) << s;
+            destino[s] = d.destino;
+            if (d.destino >= 0) tag[d.destino] = s;
+            emVoo++;
+            busca();
+        }
+    }
+
+    // marca as que escrevem neste ciclo e conta o tempo das prontas; depois faz as escritas, com as regras de
+    // MotorLockstep::escreve, e calcula os ciclos ociosos para o próximo ciclo
+    void executaEstacoes() {
+        std::array<int32_t, NUM_ESTACOES> escrita;
+        int32_t algum = 0;
+        for (int s = 0; s < NUM_ESTACOES; ++s) {
+            int32_t p = pronta(s), t = tempo[s];
+            escrita[s] = p & (t == -1);
+            algum |= escrita[s];
+            t -= p & (t > 0);
+            tempo[s] = t | -(p & (t == 0));
+        }
+        if (algum) {
+            for (int p = 0; p < NUM_ESTACOES; ++p) {
+                if (escrita[p]) escreve(p);
+            }
+        }
+        int32_t ate = INT32_MAX;
+        for (int s = 0; s < NUM_ESTACOES; ++s) {
+            int32_t t = pronta(s) ? std::max(tempo[s] - 1, 0) : INT32_MAX;
+            ate = std::min(ate, t);
+        }
+        ociosos = ate;
+    }
+
+    // sem limite de CDBs, a ordem das escritas do ciclo não muda o resultado; só as estações marcadas em
+    // esperando[p] são visitadas
+    void escreve(int32_t p) {
+        int32_t r = destino[p];
+        if (r >= 0 && tag[r] == p) tag[r] = -1;
+        ocupado[p] = 0;
+        emVoo--;
+        concluidas++;
+        for (uint64_t resto = esperando[p]; resto; resto &= resto - 1) {
+            int c = __builtin_ctzll(resto);
+            bool libera1 = q1[c] == p;
+            bool libera2 = q2[c] == p && !(c >= NUM_ARITMETICAS && libera1); // buffer esperando p nas duas fontes: só Qi
+            if (libera1) q1[c] = -1;
+            if (libera2) q2[c] = -1;
+            if (c >= NUM_ARITMETICAS) { // buffer de memória: um ciclo por operando liberado
+                tempo[c] -= libera1 && tempo[c] > 0;
+                tempo[c] -= libera2 && tempo[c] > 0;
+            } else { // aritmética: um ciclo quando Qj e Qk ficam livres
+                tempo[c] -= q1[c] < 0 && q2[c] < 0 && tempo[c] > 0;
+            }
+            if (q1[c] != p && q2[c] != p) esperando[p] &= ~(uint64_t(1) << c);
+        }
+    }
+};
+
+struct NucleoRegistrado { // uma forma instanciada: teste da configuração e ponto de entrada do seu núcleo
+    const char* nome;
+    bool (*casa)(const ConfigSimulador&);
+    ResumoExecucao (*executa)(FonteInstrucoes&, size_t, long long);
+};
+
+template <class Forma>
+constexpr NucleoRegistrado registraNucleo() {
+    return {Forma::nome, &NucleoFixo<Forma>::casa, &NucleoFixo<Forma>::executa};
+}
+
+const NucleoRegistrado NUCLEOS_FIXOS[] = { // formas instanciadas; para mais uma, declare a FormaX e acrescente registraNucleo<FormaX>()
+    registraNucleo<FormaInput>(),
+    registraNucleo<FormaInput2>(),
+};
+
+const NucleoRegistrado* buscaNucleoFixo(const ConfigSimulador& c) { // nulo: nenhuma forma casa, fica com o Estado
+    for (const NucleoRegistrado& n : NUCLEOS_FIXOS) {
+        if (n.casa(c)) return &n;
+    }
+    return nullptr;
+}
+
+bool executaVarredura(const std::string& filename, const std::vector<FaixaVarredura>& faixas, unsigned numThreads, long long cycle_limit,
+                      int64_t avanco, bool lockstep, bool especializados, FormatoRelatorio formato, std::ostream& out) { // roda o produto cartesiano das faixas sobre o mesmo trace, lido e decodificado uma vez
+    TraceCompartilhado trace;
+    if (!trace.abre(filename)) return false;
+
+    size_t total = 1;
+    for (const auto& f : faixas) total *= f.valores.size();
+    std::vector<std::vector<int>> valores(total);
+    std::vector<ConfigSimulador> configs(total, trace.config);
+    for (size_t i = 0; i < total; ++i) {
+        size_t resto = i;
+        valores[i].resize(faixas.size());
+        for (size_t k = faixas.size(); k-- > 0;) {
+            valores[i][k] = faixas[k].valores[resto % faixas[k].valores.size()];
+            resto /= faixas[k].valores.size();
+        }
+        for (size_t k = 0; k < faixas.size(); ++k) {
+            if (const ParametroEscalar* parametro = buscaParametroEscalar(faixas[k].secao)) {
+                defineParametro(configs[i], *parametro, valores[i][k]);
+            } else {
+                auto& secao = faixas[k].secao == "CYCLES" ? configs[i].ciclos : (faixas[k].secao == "UNITS" ? configs[i].unidades : configs[i].unidadesMem);
+                secao[faixas[k].nome] = valores[i][k];
+            }
+        }
+    }
+
+    // configurações de uma forma registrada vão para o seu núcleo especializado; as que o motor em lockstep cobre,
+    // em lotes de até LANES_LOTE; as demais, uma a uma num Estado
+    bool modeloSimples = (lockstep || especializados) && avanco == 0;
+    if (modeloSimples) { // opcode sem classe: o Estado acusa o erro a cada tentativa de emissão
+        if (trace.binario) {
+            for (uint64_t j = 0; j < trace.binario->numInstrucoes && modeloSimples; ++j) modeloSimples = trace.binario->instrucao(j).classe != ClasseUF::Nenhuma;
+        } else {
+            for (const auto& d : trace.programa->instrucoes) modeloSimples = modeloSimples && d.classe != ClasseUF::Nenhuma;
+        }
+    }
+    std::vector<std::vector<size_t>> lotes; // lotes[t]: configurações da tarefa t
+    std::vector<uint8_t> emLockstep;
+    std::vector<const NucleoRegistrado*> nucleos; // nucleos[t]: núcleo especializado da tarefa t, ou nulo
+    for (size_t i = 0; i < total; ++i) {
+        const NucleoRegistrado* nucleo = modeloSimples && especializados ? buscaNucleoFixo(configs[i]) : nullptr;
+        bool lane = !nucleo && modeloSimples && lockstep && MotorLockstep::suporta(configs[i]);
+        if (lane && !lotes.empty() && emLockstep.back() && lotes.back().size() < LANES_LOTE) {
+            lotes.back().push_back(i);
+            continue;
+        }
+        lotes.push_back({i});
+        emLockstep.push_back(lane);
+        nucleos.push_back(nucleo);
+    }
+
+    // cada tarefa só escreve nos resumos das suas configurações; trace e programa são somente leitura
+    std::vector<ResumoExecucao> resumos(total);
+    PoolTrabalho pool(numThreads);
+    pool.executa(lotes.size(), [&](size_t t) {
+        if (emLockstep[t]) {
+            std::vector<const ConfigSimulador*> lanes;
+            for (size_t i : lotes[t]) lanes.push_back(&configs[i]);
+            std::vector<ResumoExecucao> r;
+            MotorLockstep(trace, lanes).executa(cycle_limit, r);
+            for (size_t l = 0; l < lanes.size(); ++l) resumos[lotes[t][l]] = r[l];
+            return;
+        }
+        size_t i = lotes[t][0];
+        if (nucleos[t]) {
+            std::unique_ptr<FonteInstrucoes> fonte = trace.criaFonte();
+            resumos[i] = nucleos[t]->executa(*fonte, trace.programa->nomeRegistrador.size(), cycle_limit);
+            return;
+        }
+        std::unique_ptr<Estado> simulador = trace.criaSimulador(configs[i]);
+        if (avanco > 0) simulador->avancaFuncional(avanco);
+        std::string situacao = executaEmLote(*simulador, cycle_limit);
+        resumos[i] = {situacao, simulador->clock_cycle, simulador->instrucoesConcluidas()};
+    });
+
+    escreveVarredura(out, formato, faixas, valores, resumos);
+    return true;
+}
+
+// simulação por amostragem (estilo SimPoint): um passe funcional divide o trace em intervalos de instruções e
+// conta, em cada um, as instruções executadas por bloco básico, projetadas em DIMENSOES_BBV posições, e por classe
+// de unidade; k-means agrupa os intervalos e só os mais próximos do centro de cada grupo passam pelo modelo
+// detalhado, partindo de um checkpoint em memória com registradores, preditor e caches aquecidos pelo passe funcional.
+// Num trace o pc não se repete quando os laços já vêm desenrolados, então o bloco é identificado pelo conteúdo
+// (opcode e registradores de cada instrução), até um desvio ou MAX_BLOCO_BBV instruções
+constexpr int DIMENSOES_BBV = 32;
+constexpr int DIMENSOES_VETOR = DIMENSOES_BBV + NUM_CLASSES_UF;
+constexpr int MAX_BLOCO_BBV = 16;
+constexpr int64_t MAX_INTERVALOS_AMOSTRAGEM = 1 << 20;
+
+struct ParametrosAmostragem {
+    int64_t intervalo = 0;     // instruções por intervalo
+    int grupos = 10;
+    int amostrasPorGrupo = 2;  // intervalos sorteados por grupo, além do mais próximo do centro; com 2 ou mais, dão a margem
+    int64_t aquecimento = -1;  // instruções simuladas em detalhe antes de cada intervalo, sem medir; -1: intervalo / 10
+    uint64_t semente = 1;
+};
+
+struct GrupoAmostragem {
+    std::vector<size_t> intervalos;   // membros, do mais próximo ao mais distante do centro
+    int64_t instrucoes = 0;
+    std::vector<size_t> sorteados;    // amostra aleatória simples dos membros (pela semente), para a margem
+    std::vector<double> cpis;         // dos sorteados que concluíram
+    size_t simulados = 0;             // intervalos distintos concluídos: o mais próximo e os sorteados
+    double cpi = 0;                   // do mais próximo do centro; se ele não concluiu, a média dos sorteados
+};
+
+struct ResultadoAmostragem {
+    int64_t instrucoes = 0;
+    size_t numIntervalos = 0;
+    int64_t simuladas = 0;            // instruções medidas em detalhe
+    std::vector<GrupoAmostragem> grupos;
+    double cpi = 0;
+    double margemCpi = -1;            // metade do intervalo de 95%; -1 se nenhum grupo tem duas amostras
+    bool truncado = false;            // passe funcional parado em MAX_INTERVALOS_AMOSTRAGEM (trace sem fim?)
+};
+
+uint64_t misturaBits(uint64_t x) { // splitmix64
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+double distancia2(const std::array<double, DIMENSOES_VETOR>& a, const std::array<double, DIMENSOES_VETOR>& b) {
+    double d = 0;
+    for (int k = 0; k < DIMENSOES_VETOR; ++k) d += (a[k] - b[k]) * (a[k] - b[k]);
+    return d;
+}
+
+// k-means com inicialização k-means++; devolve o grupo de cada vetor (grupos vazios são descartados)
+std::vector<int> agrupaVetores(const std::vector<std::array<double, DIMENSOES_VETOR>>& vetores, int k, uint64_t semente,
+                               std::vector<std::array<double, DIMENSOES_VETOR>>& centros) {
+    std::mt19937_64 rng(semente);
+    size_t n = vetores.size();
+    centros.assign(1, vetores[rng() % n]);
+    std::vector<double> d2(n);
+    while (static_cast<int>(centros.size()) < k) {
+        double soma = 0;
+        for (size_t i = 0; i < n; ++i) {
+            d2[i] = distancia2(vetores[i], centros[0]);
+            for (const auto& c : centros) d2[i] = std::min(d2[i], distancia2(vetores[i], c));
+            soma += d2[i];
+        }
+        if (soma <= 0) break; // menos vetores distintos que grupos
+        double alvo = std::uniform_real_distribution<double>(0, soma)(rng);
+        size_t escolhido = 0;
+        for (; escolhido + 1 < n && (alvo -= d2[escolhido]) > 0; ++escolhido) {}
+        centros.push_back(vetores[escolhido]);
+    }
+    std::vector<int> grupo(n, -1);
+    for (int iteracao = 0; iteracao < 100; ++iteracao) {
+        bool mudou = false;
+        for (size_t i = 0; i < n; ++i) {
+            int melhor = 0;
+            for (size_t c = 1; c < centros.size(); ++c) {
+                if (distancia2(vetores[i], centros[c]) < distancia2(vetores[i], centros[melhor])) melhor = static_cast<int>(c);
+            }
+            if (grupo[i] != melhor) mudou = true;
+            grupo[i] = melhor;
+        }
+        if (!mudou) break;
+        std::vector<std::array<double, DIMENSOES_VETOR>> somas(centros.size(), std::array<double, DIMENSOES_VETOR>{});
+        std::vector<size_t> membros(centros.size(), 0);
+        for (size_t i = 0; i < n; ++i) {
+            for (int d = 0; d < DIMENSOES_VETOR; ++d) somas[grupo[i]][d] += vetores[i][d];
+            membros[grupo[i]]++;
+        }
+        for (size_t c = 0; c < centros.size(); ++c) {
+            if (membros[c] == 0) continue;
+            for (int d = 0; d < DIMENSOES_VETOR; ++d) centros[c][d] = somas[c][d] / membros[c];
+        }
+    }
+    std::vector<int> renumerado(centros.size(), -1); // sem os grupos vazios, na ordem do primeiro membro
+    std::vector<std::array<double, DIMENSOES_VETOR>> usados;
+    for (int& g : grupo) {
+        if (renumerado[g] < 0) {
+            renumerado[g] = static_cast<int>(usados.size());
+            usados.push_back(centros[g]);
+        }
+        g = renumerado[g];
+    }
+    centros = std::move(usados);
+    return grupo;
+}
+
+bool executaAmostragem(const std::string& filename, const ParametrosAmostragem& params, unsigned numThreads, long long cycle_limit,
+                       ResultadoAmostragem& r) {
+    TraceCompartilhado trace;
+    if (!trace.abre(filename)) return false;
+
+    // 1) passe funcional: vetor de blocos básicos de cada intervalo
+    std::vector<std::array<double, DIMENSOES_VETOR>> vetores;
+    std::vector<int64_t> tamanhos;
+    {
+        std::unique_ptr<Estado> perfil = trace.criaSimulador(trace.config);
+        std::array<double, DIMENSOES_VETOR> atual{};
+        int64_t noIntervalo = 0;
+        int64_t pcAnterior = -1;
+        uint64_t bloco = 0; // hash do conteúdo do bloco até a instrução atual
+        int noBloco = MAX_BLOCO_BBV;
+        auto fechaIntervalo = [&]() {
+            for (double& v : atual) v /= noIntervalo;
+            vetores.push_back(atual);
+            tamanhos.push_back(noIntervalo);
+            atual.fill(0);
+            noIntervalo = 0;
+        };
+        int64_t avancadas = 1;
+        while (avancadas > 0 && static_cast<int64_t>(vetores.size()) < MAX_INTERVALOS_AMOSTRAGEM) {
+            avancadas = perfil->avancaFuncional(params.intervalo - noIntervalo, [&](const EstadoInstrucao& instr) {
+                const InstrucaoDecodificada& d = instr.instrucao;
+                if (noBloco == MAX_BLOCO_BBV || instr.pc != pcAnterior + 1) { // depois de um desvio, de um salto ou do tamanho máximo
+                    bloco = 0;
+                    noBloco = 0;
+                }
+                bloco = misturaBits(bloco ^ static_cast<uint64_t>(d.op) ^ (static_cast<uint64_t>(d.destino + 1) << 8) ^
+                                    (static_cast<uint64_t>(d.fonteJ.registrador + 1) << 24) ^ (static_cast<uint64_t>(d.fonteK.registrador + 1) << 40));
+                noBloco = (d.flags & DESVIO) ? MAX_BLOCO_BBV : noBloco + 1;
+                pcAnterior = instr.pc;
+                atual[bloco % DIMENSOES_BBV] += 1;
+                if (d.classe != ClasseUF::Nenhuma) atual[DIMENSOES_BBV + static_cast<int>(d.classe)] += 1;
+                noIntervalo++;
+            });
+            if (noIntervalo == params.intervalo || (avancadas == 0 && noIntervalo > 0)) fechaIntervalo();
+        }
+        r.truncado = avancadas > 0;
+    }
+    if (vetores.empty()) {
+        std::cerr << "Error: No instructions found in the input file." << std::endl;
+        return false;
+    }
+    r.numIntervalos = vetores.size();
+    r.instrucoes = std::accumulate(tamanhos.begin(), tamanhos.end(), int64_t(0));
+
+    // 2) agrupamento e escolha dos intervalos a simular
+    std::vector<std::array<double, DIMENSOES_VETOR>> centros;
+    std::vector<int> grupo = agrupaVetores(vetores, std::max(1, params.grupos), params.semente, centros);
+    r.grupos.assign(centros.size(), GrupoAmostragem());
+    for (size_t i = 0; i < vetores.size(); ++i) {
+        r.grupos[grupo[i]].intervalos.push_back(i);
+        r.grupos[grupo[i]].instrucoes += tamanhos[i];
+    }
+    // o mais próximo do centro dá o CPI do grupo; a margem vem de intervalos sorteados, sem reposição, entre todos os
+    // membros (o mais próximo pode sair no sorteio, e então é simulado uma vez só)
+    std::mt19937_64 sorteio(misturaBits(params.semente)); // independente do k-means
+    std::vector<std::pair<size_t, int>> escolhidos; // (intervalo, grupo)
+    for (size_t g = 0; g < r.grupos.size(); ++g) {
+        auto& membros = r.grupos[g].intervalos;
+        std::stable_sort(membros.begin(), membros.end(), [&](size_t a, size_t b) {
+            return distancia2(vetores[a], centros[g]) < distancia2(vetores[b], centros[g]);
+        });
+        std::vector<size_t> embaralhados = membros;
+        size_t m = std::min(embaralhados.size(), static_cast<size_t>(std::max(0, params.amostrasPorGrupo)));
+        for (size_t k = 0; k < m; ++k) std::swap(embaralhados[k], embaralhados[k + sorteio() % (embaralhados.size() - k)]);
+        r.grupos[g].sorteados.assign(embaralhados.begin(), embaralhados.begin() + m);
+        escolhidos.push_back({membros[0], static_cast<int>(g)});
+        for (size_t i : r.grupos[g].sorteados) escolhidos.push_back({i, static_cast<int>(g)});
+    }
+    std::sort(escolhidos.begin(), escolhidos.end());
+    escolhidos.erase(std::unique(escolhidos.begin(), escolhidos.end()), escolhidos.end());
+
+    // 3) um segundo passe funcional grava um checkpoint em memória no início do aquecimento de cada escolhido
+    int64_t aquecimento = params.aquecimento >= 0 ? params.aquecimento : params.intervalo / 10;
+    std::vector<std::string> checkpoints(escolhidos.size());
+    std::vector<int64_t> aquecimentos(escolhidos.size());
+    {
+        std::unique_ptr<Estado> funcional = trace.criaSimulador(trace.config);
+        int64_t posicao = 0;
+        for (size_t e = 0; e < escolhidos.size(); ++e) {
+            int64_t inicio = static_cast<int64_t>(escolhidos[e].first) * params.intervalo;
+            int64_t ponto = std::max(posicao, inicio - aquecimento);
+            posicao += funcional->avancaFuncional(ponto - posicao);
+            aquecimentos[e] = inicio - posicao;
+            std::ostringstream out;
+            ArquivoEstado a(out);
+            funcional->serializa(a);
+            checkpoints[e] = out.str();
+        }
+    }
+
+    // 4) simulação detalhada dos escolhidos, em paralelo; cada tarefa só escreve em cpis[e]
+    std::vector<double> cpis(escolhidos.size(), -1);
+    PoolTrabalho pool(numThreads);
+    pool.executa(escolhidos.size(), [&](size_t e) {
+        std::unique_ptr<Estado> simulador = trace.criaSimulador(trace.config);
+        std::istringstream in(checkpoints[e]);
+        ArquivoEstado a(in, checkpoints[e].size());
+        simulador->serializa(a);
+        if (!a.ok()) return;
+        std::string situacao = "limite";
+        if (aquecimentos[e] > 0) situacao = executaEmLote(*simulador, cycle_limit, 0, {}, aquecimentos[e]);
+        if (situacao != "limite" || (cycle_limit > 0 && simulador->clock_cycle >= cycle_limit)) return;
+        int64_t ciclos = simulador->clock_cycle, concluidas = simulador->instrucoesConcluidas();
+        situacao = executaEmLote(*simulador, cycle_limit, 0, {}, concluidas + tamanhos[escolhidos[e].first]);
+        if (situacao == "travada" || (situacao == "limite" && simulador->instrucoesConcluidas() < concluidas + tamanhos[escolhidos[e].first])) return;
+        cpis[e] = static_cast<double>(simulador->clock_cycle - ciclos) / (simulador->instrucoesConcluidas() - concluidas);
+    });
+
+    // 5) extrapolação: CPI do mais próximo do centro ponderado pelas instruções de cada grupo; margem de 95% da
+    // amostragem estratificada, com a variância de cada grupo estimada nos sorteados
+    for (size_t e = 0; e < escolhidos.size(); ++e) {
+        if (cpis[e] < 0) {
+            std::cerr << "Warning: Interval " << escolhidos[e].first << " did not complete in detailed mode; ignoring it" << std::endl;
+            continue;
+        }
+        r.grupos[escolhidos[e].second].simulados++;
+        r.simuladas += tamanhos[escolhidos[e].first];
+    }
+    auto cpiDe = [&](size_t intervalo, int g) {
+        return cpis[std::lower_bound(escolhidos.begin(), escolhidos.end(), std::make_pair(intervalo, g)) - escolhidos.begin()];
+    };
+    double somaPesos = 0, somaVariancias = 0;
+    int gruposComVariancia = 0;
+    for (size_t k = 0; k < r.grupos.size(); ++k) {
+        GrupoAmostragem& g = r.grupos[k];
+        for (size_t i : g.sorteados) {
+            if (cpiDe(i, static_cast<int>(k)) >= 0) g.cpis.push_back(cpiDe(i, static_cast<int>(k)));
+        }
+        double mediaSorteados = g.cpis.empty() ? 0 : std::accumulate(g.cpis.begin(), g.cpis.end(), 0.0) / g.cpis.size();
+        double representante = cpiDe(g.intervalos[0], static_cast<int>(k));
+        if (representante < 0 && g.cpis.empty()) continue;
+        g.cpi = representante >= 0 ? representante : mediaSorteados;
+        double peso = static_cast<double>(g.instrucoes) / r.instrucoes;
+        somaPesos += peso;
+        r.cpi += peso * g.cpi;
+        if (g.cpis.size() >= 2) {
+            double variancia = 0;
+            for (double c : g.cpis) variancia += (c - mediaSorteados) * (c - mediaSorteados);
+            variancia /= g.cpis.size() - 1;
+            double m = static_cast<double>(g.cpis.size());
+            somaVariancias += peso * peso * (1 - m / g.intervalos.size()) * variancia / m;
+            gruposComVariancia++;
+        }
+    }
+    if (somaPesos <= 0) {
+        std::cerr << "Error: No sampled interval completed in detailed mode" << std::endl;
+        return false;
+    }
+    r.cpi /= somaPesos; // grupos sem intervalo concluído ficam de fora
+    if (gruposComVariancia > 0) r.margemCpi = 1.96 * std::sqrt(somaVariancias);
+    return true;
+}
+
+void escreveAmostragem(std::ostream& out, FormatoRelatorio formato, const ResultadoAmostragem& r, const ParametrosAmostragem& params) {
+    double ipc = r.cpi > 0 ? 1 / r.cpi : 0;
+    double ciclos = r.cpi * r.instrucoes;
+    double margemCiclos = r.margemCpi >= 0 ? r.margemCpi * r.instrucoes : -1;
+    out << std::fixed << std::setprecision(4);
+    if (formato == FormatoRelatorio::Texto) {
+        out << "== Simulacao por Amostragem ==\n";
+        out << "Instrucoes: " << r.instrucoes << " em " << r.numIntervalos << " intervalos de " << params.intervalo << (r.truncado ? " (trace truncado)" : "") << '\n';
+        out << "Simuladas em detalhe: " << r.simuladas << " (" << std::setprecision(1) << 100.0 * r.simuladas / r.instrucoes << "%)\n" << std::setprecision(4);
+        out << std::left << std::setw(7) << "Grupo" << std::setw(12) << "Intervalos" << std::setw(9) << "Peso" << std::setw(11) << "Simulados" << "CPI" << '\n';
+        for (size_t g = 0; g < r.grupos.size(); ++g) {
+            const GrupoAmostragem& grupo = r.grupos[g];
+            out << std::left << std::setw(7) << g << std::setw(12) << grupo.intervalos.size() << std::setw(9) << static_cast<double>(grupo.instrucoes) / r.instrucoes
+                << std::setw(11) << grupo.simulados << grupo.cpi << '\n';
+        }
+        out << "CPI estimado: " << r.cpi;
+        if (r.margemCpi >= 0) out << " +- " << r.margemCpi << " (95%)";
+        out << "\nIPC estimado: " << ipc;
+        if (r.margemCpi >= 0 && r.cpi > r.margemCpi) out << " (" << 1 / (r.cpi + r.margemCpi) << " a " << 1 / (r.cpi - r.margemCpi) << ")";
+        out << "\nCiclos estimados: " << std::setprecision(0) << ciclos;
+        if (margemCiclos >= 0) out << " +- " << margemCiclos;
+        out << '\n';
+        if (r.margemCpi < 0) out << "Margem indisponivel: nenhum grupo com dois intervalos sorteados\n";
+    } else if (formato == FormatoRelatorio::Csv) {
+        out << "instrucoes,intervalos,simuladas,cpi,margem_cpi,ipc,ciclos,margem_ciclos\n";
+        out << r.instrucoes << ',' << r.numIntervalos << ',' << r.simuladas << ',' << r.cpi << ',';
+        if (r.margemCpi >= 0) out << r.margemCpi;
+        out << ',' << ipc << ',' << std::setprecision(0) << ciclos << ',';
+        if (margemCiclos >= 0) out << margemCiclos;
+        out << std::setprecision(4) << "\n\ngrupo,intervalos,peso,simulados,cpi\n";
+        for (size_t g = 0; g < r.grupos.size(); ++g) {
+            const GrupoAmostragem& grupo = r.grupos[g];
+            out << g << ',' << grupo.intervalos.size() << ',' << static_cast<double>(grupo.instrucoes) / r.instrucoes << ',' << grupo.simulados << ',' << grupo.cpi << '\n';
+        }
+    } else {
+        out << "{\"instrucoes\":" << r.instrucoes << ",\"intervalos\":" << r.numIntervalos << ",\"simuladas\":" << r.simuladas
+            << ",\"cpi\":" << r.cpi << ",\"margem_cpi\":";
+        if (r.margemCpi >= 0) out << r.margemCpi;
+        else out << "null";
+        out << ",\"ipc\":" << ipc << ",\"ciclos\":" << std::setprecision(0) << ciclos << ",\"margem_ciclos\":";
+        if (margemCiclos >= 0) out << margemCiclos;
+        else out << "null";
+        out << std::setprecision(4) << ",\"grupos\":[";
+        for (size_t g = 0; g < r.grupos.size(); ++g) {
+            const GrupoAmostragem& grupo = r.grupos[g];
+            out << (g ? "," : "") << "{\"intervalos\":" << grupo.intervalos.size() << ",\"peso\":" << static_cast<double>(grupo.instrucoes) / r.instrucoes
+                << ",\"simulados\":" << grupo.simulados << ",\"cpi\":" << grupo.cpi << '}';
+        }
+        out << "]}\n";
+    }
+}
+
+void executaAvanco(Estado& simulador, int64_t avanco) {
+    int64_t avancadas = simulador.avancaFuncional(avanco);
+    if (avancadas < avanco) {
+        std::cerr << "Warning: The trace ended after " << avancadas << " of the " << avanco << " fast-forward instructions" << std::endl;
+    }
+}
+
+// re-simulação incremental (--incremental): a execução grava fotos periódicas do Estado (o conteúdo de um
+// checkpoint) e, com cada uma, do que a simulação dependeu até ali: quantas posições do trace leu (com um hash desse
+// prefixo), as listas de estações (classe, aritmética ou de memória) das instruções buscadas e até que registrador
+// usou. Na execução seguinte, com o trace ou a configuração editados, a simulação continua da última foto ainda
+// válida: o prefixo lido não mudou, a configuração fora de CYCLES, UNITS e MEM_UNITS é a mesma e nenhuma classe cuja
+// latência ou número de estações mudou tinha sido buscada
+constexpr char MAGICA_INCREMENTAL[8] = {'T', 'O', 'M', 'A', 'S', 'I', 'N', 'C'};
+constexpr uint32_t VERSAO_INCREMENTAL = 2;
+constexpr size_t MAX_FOTOS_INCREMENTAL = 64; // passando disso, descarta uma foto a cada duas e dobra o intervalo
+
+int listaEstacoes(const InstrucaoDecodificada& d) { return d.memoria() * NUM_CLASSES_UF + static_cast<int>(d.classe); }
+
+class FonteIncremental : public FonteInstrucoes { // percorre o trace compartilhado anotando do que a simulação já dependeu
+public:
+    int64_t alcance = 0;       // posições lidas: [0, alcance); a posição numInstrucoes é o fim do trace
+    uint32_t listas = 0;       // bit listaEstacoes das instruções buscadas
+    int64_t registradores = 0; // registradores [0, registradores) referenciados
+
+    explicit FonteIncremental(const TraceCompartilhado& trace) : trace(trace), n(trace.numInstrucoes()) {}
+    bool proxima(InstrucaoDecodificada& out) override {
+        alcance = std::max(alcance, i + 1);
+        if (i >= n) return false;
+        out = trace.instrucao(i++);
+        if (out.classe != ClasseUF::Nenhuma) listas |= 1u << listaEstacoes(out);
+        registradores = std::max<int64_t>(registradores, std::max({out.destino, out.fonteJ.registrador, out.fonteK.registrador}) + 1);
+        return true;
+    }
+    bool vazia() override {
+        alcance = std::max(alcance, i + 1); // como em proxima: a resposta depende do fim do trace
+        return i >= n;
+    }
+    bool posiciona(int64_t indice) override {
+        i = std::min(indice, n);
+        return true;
+    }
+
+private:
+    const TraceCompartilhado& trace;
+    int64_t n;
+    int64_t i = 0;
+};
+
+struct FotoIncremental { // o Estado num ciclo e do que ele dependeu
+    int64_t ciclo = 0;
+    int64_t alcance = 0;
+    uint64_t prefixo = 0; // hash das posições [0, alcance) do trace
+    uint32_t listas = 0;
+    int64_t registradores = 0;
+    int64_t entregues = 0; // resultados registrados até o ciclo: prefixo de ArquivoIncremental::resultados
+    int32_t latencias[NUM_CLASSES_UF] = {};
+    std::vector<char> nomes; // disposição das estações: nomes separados por '\n', classes e limites
+    std::vector<ClasseUF> classes;
+    uint64_t numAritmeticas = 0;
+    uint64_t inicioEstagios = 0;
+    std::vector<char> estado; // Estado::serializa
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(ciclo);
+        a.campo(alcance);
+        a.campo(prefixo);
+        a.campo(listas);
+        a.campo(registradores);
+        a.campo(entregues);
+        a.campo(latencias);
+        a.campo(nomes);
+        a.campo(classes);
+        a.campo(numAritmeticas);
+        a.campo(inicioEstagios);
+        a.campo(estado);
+    }
+
+    EstacoesReserva disposicao() const {
+        EstacoesReserva r;
+        std::string nome;
+        size_t k = 0;
+        for (char c : nomes) {
+            if (c != '\n') {
+                nome += c;
+                continue;
+            }
+            r.adiciona(nome, k < classes.size() ? classes[k] : ClasseUF::Nenhuma);
+            nome.clear();
+            k++;
+        }
+        r.numAritmeticas = static_cast<size_t>(numAritmeticas);
+        r.inicioEstagios = static_cast<size_t>(inicioEstagios);
+        return r;
+    }
+};
+
+struct ArquivoIncremental {
+    std::vector<char> config; // configuração sem CYCLES, UNITS e MEM_UNITS, com o bloco de dados
+    int64_t intervalo = 0;    // ciclos entre fotos
+    uint8_t comResultados = 0;
+    std::vector<ResultadoInstrucao> resultados; // registrados, na ordem em que as instruções escreveram
+    std::vector<FotoIncremental> fotos;         // em ordem de ciclo
+
+    void serializa(ArquivoEstado& a) {
+        a.campo(config);
+        a.campo(intervalo);
+        a.campo(comResultados);
+        a.campo(resultados);
+        a.campo(fotos);
+    }
+};
+
+std::vector<char> configFixa(const ConfigSimulador& config) { // o que nenhuma foto sobrevive a mudar
+    ConfigSimulador c = config;
+    c.ciclos.clear();
+    c.unidades.clear();
+    c.unidadesMem.clear();
+    std::ostringstream out;
+    escreveConfig(out, c);
+    for (const auto& r : config.dados.registradores) out << r.first << ' ' << r.second << '\n';
+    for (const auto& p : config.dados.memoria) out << p.endereco << ' ' << p.valor << ' ' << p.pontoFlutuante << '\n';
+    std::string texto = out.str();
+    return std::vector<char>(texto.begin(), texto.end());
+}
+
+std::vector<std::string> chavesEstacoes(const EstacoesReserva& e) { // uma por estação: nome, classe, lista e estágio de PIPES
+    std::vector<std::string> r;
+    for (size_t s = 0; s < e.size(); ++s) {
+        r.push_back(e.nome[s] + '\n' + static_cast<char>(e.classe[s]) + static_cast<char>(s >= e.numAritmeticas) + static_cast<char>(e.estagio(s)));
+    }
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+std::vector<uint64_t> prefixosTrace(const TraceCompartilhado& trace) { // [k]: hash das posições [0, k), com o fim do trace na posição n
+    int64_t n = trace.numInstrucoes();
+    std::vector<uint64_t> h(static_cast<size_t>(n) + 2, 0);
+    for (int64_t i = 0; i < n; ++i) {
+        InstrucaoDecodificada d = trace.instrucao(i);
+        uint64_t x = h[i];
+        for (uint64_t v : {static_cast<uint64_t>(d.op), static_cast<uint64_t>(d.classe), static_cast<uint64_t>(d.flags), static_cast<uint64_t>(d.destino),
+                           static_cast<uint64_t>(d.fonteJ.nome), static_cast<uint64_t>(d.fonteJ.registrador), static_cast<uint64_t>(d.fonteK.nome),
+                           static_cast<uint64_t>(d.fonteK.registrador), static_cast<uint64_t>(d.imediato), static_cast<uint64_t>(d.padrao)}) {
+            x = misturaBits(x ^ v);
+        }
+        for (uint32_t t : d.texto) x = misturaBits(x ^ t);
+        if (d.flags & DESVIO) x = misturaBits(x ^ static_cast<uint64_t>(trace.programa->alvo(d, i))); // o rótulo pode estar adiante
+        h[i + 1] = x;
+    }
+    h[n + 1] = misturaBits(h[n] ^ 0xF1Aull);
+    return h;
+}
+
+struct EntradaIncremental { // o que a execução atual oferece para validar uma foto
+    std::vector<char> config;
+    int32_t latencias[NUM_CLASSES_UF];
+    std::vector<std::string> estacoes; // chavesEstacoes
+    std::vector<uint64_t> prefixos;
+    long long cycle_limit;
+};
+
+bool fotoValida(const FotoIncremental& f, const EntradaIncremental& e) {
+    if (e.cycle_limit > 0 && f.ciclo > e.cycle_limit) return false;
+    if (f.alcance < 0 || f.alcance >= static_cast<int64_t>(e.prefixos.size()) || e.prefixos[f.alcance] != f.prefixo) return false;
+    uint32_t mudou = 0; // listas cuja latência ou estações mudaram
+    for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+        if (f.latencias[c] != e.latencias[c]) mudou |= (1u << c) | (1u << (NUM_CLASSES_UF + c));
+    }
+    std::vector<std::string> antigas = chavesEstacoes(f.disposicao()), diferentes;
+    std::set_symmetric_difference(antigas.begin(), antigas.end(), e.estacoes.begin(), e.estacoes.end(), std::back_inserter(diferentes));
+    for (const std::string& k : diferentes) {
+        ClasseUF classe = static_cast<ClasseUF>(k[k.size() - 3]);
+        if (classe != ClasseUF::Nenhuma) mudou |= 1u << (k[k.size() - 2] * NUM_CLASSES_UF + static_cast<int>(classe));
+    }
+    return (f.listas & mudou) == 0;
+}
+
+FotoIncremental fotografa(Estado& estado, const FonteIncremental& fonte, const EntradaIncremental& e, int64_t entregues) {
+    FotoIncremental f;
+    f.ciclo = estado.clock_cycle;
+    f.alcance = fonte.alcance;
+    f.prefixo = e.prefixos[fonte.alcance];
+    f.listas = fonte.listas;
+    f.registradores = fonte.registradores;
+    f.entregues = entregues;
+    std::copy(e.latencias, e.latencias + NUM_CLASSES_UF, f.latencias);
+    for (size_t s = 0; s < estado.estacoes.size(); ++s) {
+        f.nomes.insert(f.nomes.end(), estado.estacoes.nome[s].begin(), estado.estacoes.nome[s].end());
+        f.nomes.push_back('\n');
+    }
+    f.classes = estado.estacoes.classe;
+    f.numAritmeticas = estado.estacoes.numAritmeticas;
+    f.inicioEstagios = estado.estacoes.inicioEstagios;
+    std::ostringstream out;
+    ArquivoEstado a(out);
+    estado.serializa(a);
+    std::string bytes = out.str();
+    f.estado.assign(bytes.begin(), bytes.end());
+    return f;
+}
+
+bool restauraFoto(Estado& estado, const FotoIncremental& f) {
+    std::istringstream in(std::string(f.estado.begin(), f.estado.end()));
+    ArquivoEstado a(in, f.estado.size());
+    EstacoesReserva disposicao = f.disposicao();
+    if (disposicao.nome == estado.estacoes.nome && disposicao.classe == estado.estacoes.classe && disposicao.numAritmeticas == estado.estacoes.numAritmeticas &&
+        disposicao.inicioEstagios == estado.estacoes.inicioEstagios) {
+        estado.serializa(a);
+        if (!a.ok()) return false;
+    } else if (!estado.restauraOutraDisposicao(a, disposicao)) {
+        return false;
+    }
+    estado.recriaRegistradores(static_cast<size_t>(f.registradores));
+    return true;
+}
+
+bool leIncremental(const std::string& arquivo, ArquivoIncremental& r) { // false se o arquivo não existe ou não serve
+    std::ifstream in(arquivo, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    uint64_t tamanho = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    ArquivoEstado a(in, tamanho);
+    char magica[8] = {};
+    uint32_t versao = 0;
+    a.campo(magica);
+    a.campo(versao);
+    if (a.ok() && std::equal(magica, magica + 8, MAGICA_INCREMENTAL) && versao == VERSAO_INCREMENTAL) r.serializa(a);
+    if (!a.ok() || !std::equal(magica, magica + 8, MAGICA_INCREMENTAL) || versao != VERSAO_INCREMENTAL) {
+        std::cerr << "Warning: Ignoring invalid incremental file " << arquivo << "; simulating from cycle 0" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool gravaIncremental(const std::string& arquivo, ArquivoIncremental& r) {
+    std::ofstream out(arquivo, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << arquivo << std::endl;
+        return false;
+    }
+    ArquivoEstado a(out);
+    out.write(MAGICA_INCREMENTAL, 8);
+    gravaValor(out, VERSAO_INCREMENTAL);
+    r.serializa(a);
+    if (!a.ok()) {
+        std::cerr << "Error: Could not write file " << arquivo << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// modo --quieto com --incremental: o mesmo relatório, partindo da última foto válida de arquivo e regravando-o
+bool executaIncremental(const std::string& filename, const std::string& arquivo, int64_t intervalo, long long cycle_limit, bool lista_instrucoes,
+                        FormatoRelatorio formato, std::ostream& out) {
+    TraceCompartilhado trace;
+    if (!trace.abre(filename)) return false;
+    if (trace.config.tamanhoL1 > 0 && !trace.config.funcional) {
+        std::cerr << "Warning: L1D_SIZE needs FUNCTIONAL 1 for real addresses; using the fixed Load/Store latency" << std::endl;
+    }
+    int64_t n = trace.numInstrucoes();
+    if (n == 0) {
+        std::cout << "No instructions found in the input file." << std::endl;
+        return true;
+    }
+    FonteIncremental* fonte = nullptr;
+    auto criaEstado = [&]() {
+        auto f = std::make_unique<FonteIncremental>(trace);
+        fonte = f.get();
+        return std::make_unique<Estado>(trace.config, trace.programa, std::move(f));
+    };
+    std::unique_ptr<Estado> estado = criaEstado();
+
+    EntradaIncremental entrada;
+    entrada.config = configFixa(trace.config);
+    for (int c = 0; c < NUM_CLASSES_UF; ++c) {
+        auto it = trace.config.ciclos.find(NOMES_CLASSES_UF[c]);
+        entrada.latencias[c] = it != trace.config.ciclos.end() ? it->second : 1;
+    }
+    entrada.estacoes = chavesEstacoes(estado->estacoes);
+    entrada.prefixos = prefixosTrace(trace);
+    entrada.cycle_limit = cycle_limit;
+
+    ArquivoIncremental anterior, atual;
+    atual.config = entrada.config;
+    atual.intervalo = intervalo;
+    atual.comResultados = lista_instrucoes;
+    if (leIncremental(arquivo, anterior) && anterior.config == entrada.config && (!lista_instrucoes || anterior.comResultados)) {
+        for (size_t k = anterior.fotos.size(); k-- > 0;) {
+            const FotoIncremental& f = anterior.fotos[k];
+            if (!fotoValida(f, entrada) || (lista_instrucoes && f.entregues > static_cast<int64_t>(anterior.resultados.size()))) continue;
+            if (!restauraFoto(*estado, f)) {
+                estado = criaEstado();
+                continue;
+            }
+            fonte->alcance = f.alcance;
+            fonte->listas = f.listas;
+            fonte->registradores = f.registradores;
+            if (lista_instrucoes) atual.resultados.assign(anterior.resultados.begin(), anterior.resultados.begin() + f.entregues);
+            atual.intervalo = std::max(intervalo, anterior.intervalo);
+            for (size_t j = 0; j <= k; ++j) { // as anteriores dependem de um prefixo do que esta dependeu
+                if (fotoValida(anterior.fotos[j], entrada)) atual.fotos.push_back(std::move(anterior.fotos[j]));
+            }
+            std::cerr << "Incremental: resuming from the snapshot at cycle " << estado->clock_cycle << std::endl;
+            break;
+        }
+    }
+
+    ColetorResultados coletor;
+    coletor.resultados = std::move(atual.resultados);
+    if (lista_instrucoes) estado->destinosResultados.push_back(&coletor);
+    std::string situacao;
+    int64_t proxima = (estado->clock_cycle / atual.intervalo + 1) * atual.intervalo;
+    while (true) { // em trechos até a próxima foto: o mesmo resultado de uma única chamada
+        long long alvo = cycle_limit > 0 ? std::min<long long>(proxima, cycle_limit) : proxima;
+        situacao = executaEmLote(*estado, alvo);
+        if (situacao != "limite" || (cycle_limit > 0 && estado->clock_cycle >= cycle_limit)) break;
+        atual.fotos.push_back(fotografa(*estado, *fonte, entrada, static_cast<int64_t>(coletor.resultados.size())));
+        if (atual.fotos.size() > MAX_FOTOS_INCREMENTAL) {
+            size_t mantidas = 0;
+            for (size_t j = atual.fotos.size() % 2; j < atual.fotos.size(); j += 2) atual.fotos[mantidas++] = std::move(atual.fotos[j]);
+            atual.fotos.resize(mantidas);
+            atual.intervalo *= 2;
+        }
+        proxima = (estado->clock_cycle / atual.intervalo + 1) * atual.intervalo;
+    }
+
+    std::vector<ResultadoInstrucao> linhas;
+    if (lista_instrucoes) {
+        atual.resultados = coletor.resultados;
+        linhas = std::move(coletor.resultados);
+        estado->resultadosEmAberto(linhas);
+        if (estado->config.tamanhoROB == 0) { // como sem fonte: as ainda não buscadas também entram, sem ciclos
+            for (int64_t i = std::min(fonte->alcance, n); i < n; ++i) {
+                ResultadoInstrucao r = {i, -1, -1, -1, -1, {}};
+                InstrucaoDecodificada d = trace.instrucao(i);
+                std::copy(d.texto, d.texto + 4, r.texto);
+                linhas.push_back(r);
+            }
+        }
+    }
+    ResumoExecucao resumo = {situacao, estado->clock_cycle, estado->instrucoesConcluidas()};
+    escreveRelatorio(out, formato, resumo, nullptr, linhas, *trace.programa);
+    if (estado->config.funcional && formato == FormatoRelatorio::Texto) estado->escreveValores(out);
+    return gravaIncremental(arquivo, atual);
+}
 
-    EstadoInstrucao() : posicao(0), busy(false) {}
-    EstadoInstrucao(InstrucaoDetalhes details, int pos)
-        : instrucao(std::move(details)), posicao(pos), busy(false) {}
-};
+// SMT: vários contextos num só núcleo, cada um com o seu trace, a sua janela, a sua tabela de registradores e o seu
+// ponteiro de emissão (um Estado por contexto); as estações de reserva e as unidades de PIPES são um conjunto só,
+// disputado pelos contextos, e a largura de emissão e os CDBs de cada ciclo são repartidos na ordem da política de
+// busca. ROB, preditor, memória e caches continuam por contexto
+enum class PoliticaBusca : uint8_t { RoundRobin, Icount };
+const char* const NOMES_POLITICAS_BUSCA[] = {"rr", "icount", nullptr};
 
-struct UnidadeFuncional {
-    std::optional<InstrucaoDetalhes> instrucao_details;
-    EstadoInstrucao* estadoInstrucaoOriginal = nullptr;
-    std::string tipoUnidade;
-    std::optional<int> tempo;
-    std::string nome;
-    bool ocupado = false;
-    std::optional<std::string> operacao;
-    std::optional<std::string> vj;
-    std::optional<std::string> vk;
-    std::optional<std::string> qj;
-    std::optional<std::string> qk;
-};
-
-struct UnidadeFuncionalMemoria {
-    std::optional<InstrucaoDetalhes> instrucao_details;
-    EstadoInstrucao* estadoInstrucaoOriginal = nullptr;
-    std::string tipoUnidade;
-    std::optional<int> tempo;
-    std::string nome;
-    bool ocupado = false;
-    std::optional<std::string> qi;
-    std::optional<std::string> qj;
-    std::optional<std::string> operacao;
-    std::optional<std::string> endereco;
-    std::optional<std::string> destino;
+struct ResultadoContexto {
+    std::string arquivo;
+    std::string situacao;
+    int64_t ciclos;     // ciclo em que o contexto terminou, ou o último simulado
+    int64_t instrucoes;
 };
 
-class Estado {
+class NucleoSMT {
 public:
-    ConfigSimulador config;
-    std::vector<EstadoInstrucao> estadoInstrucoes;
-    std::map<std::string, UnidadeFuncional> unidadesFuncionais;
-    std::map<std::string, UnidadeFuncionalMemoria> unidadesFuncionaisMemoria;
-    int clock_cycle;
-    std::map<std::string, std::optional<std::string>> estacaoRegistradores;
-
-    Estado(const ConfigSimulador& cfg, const std::vector<InstrucaoInput>& instrucoes_input) // inicialização das instruções, registradores e unidades funcionais
-        : config(cfg), clock_cycle(0) {
-        for (int i = 0; i < instrucoes_input.size(); ++i) {
-            InstrucaoDetalhes details;
-            details.operacao = instrucoes_input[i].d_operacao;
-            details.registradorR = instrucoes_input[i].r_reg;
-            details.registradorS = instrucoes_input[i].s_reg_or_imm;
-            details.registradorT = instrucoes_input[i].t_reg_or_label;
-            estadoInstrucoes.emplace_back(details, i);
-        }
-        this->config.numInstrucoes = instrucoes_input.size();
-
-        for (const auto& pair : config.unidades) {
-            const std::string& tipo = pair.first;
-            int count = pair.second;
-            for (int i = 0; i < count; ++i) {
-                UnidadeFuncional uf;
-                uf.nome = tipo + std::to_string(i + 1);
-                uf.tipoUnidade = tipo;
-                unidadesFuncionais[uf.nome] = uf;
-            }
-        }
-
-        for (const auto& pair : config.unidadesMem) {
-            const std::string& tipo = pair.first;
-            int count = pair.second;
-            for (int i = 0; i < count; ++i) {
-                UnidadeFuncionalMemoria uf_mem;
-                uf_mem.nome = tipo + std::to_string(i + 1);
-                uf_mem.tipoUnidade = tipo;
-                unidadesFuncionaisMemoria[uf_mem.nome] = uf_mem;
-            }
+    NucleoSMT(std::vector<std::unique_ptr<Estado>> contextosCriados, PoliticaBusca politica)
+        : contextos(std::move(contextosCriados)), politica(politica), fim(contextos.size(), -1) {
+        recursos = contextos[0]->recursos();
+        for (auto& c : contextos) c->compartilhados = &recursos;
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            if (contextos[t]->vazio()) fim[t] = 0;
+            ordem.push_back(t);
         }
+    }
 
-        for (int i = 0; i < 32; i += 2) {
-            estacaoRegistradores["F" + std::to_string(i)] = std::nullopt;
+    std::string executa(long long cycle_limit) { // como executaEmLote, pulando os ciclos em que nenhum contexto avança
+        while (cycle_limit == 0 || clock() < cycle_limit) {
+            int ociosos = ciclosOciosos();
+            if (ociosos < 0) return "travada";
+            if (cycle_limit > 0) ociosos = static_cast<int>(std::min<long long>(ociosos, cycle_limit - clock() - 1));
+            for (auto& c : contextos) c->saltaCiclos(ociosos);
+            if (executaCiclo()) return "concluida";
         }
-        for (int i = 0; i < 32; ++i) {
-            estacaoRegistradores["R" + std::to_string(i)] = std::nullopt;
+        return "limite";
+    }
+
+    std::vector<ResultadoContexto> resultados(const std::vector<std::string>& arquivos, const std::string& situacao) const {
+        std::vector<ResultadoContexto> r;
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            r.push_back({arquivos[t], fim[t] >= 0 ? "concluida" : situacao, fim[t] >= 0 ? fim[t] : clock(), contextos[t]->instrucoesConcluidas()});
         }
+        return r;
     }
 
-    EstadoInstrucao* getNovaInstrucao() { // retorna a próxima instrução que ainda foi emitida 
-        for (auto& instr_state : estadoInstrucoes) {
-            if (!instr_state.issue.has_value()) {
-                return &instr_state;
-            }
+    int64_t clock() const { return contextos[0]->clock_cycle; }
+
+private:
+    std::vector<std::unique_ptr<Estado>> contextos;
+    PoliticaBusca politica;
+    RecursosCompartilhados recursos;
+    std::vector<int64_t> fim; // ciclo em que cada contexto terminou, -1 se ainda não
+    std::vector<size_t> ordem;
+
+    bool executaCiclo() { // true quando todos os contextos terminaram
+        for (auto& c : contextos) c->iniciaCiclo();
+        ordenaContextos();
+        int largura = contextos[0]->config.larguraEmissao; // o que um contexto não usa passa ao seguinte
+        for (size_t t : ordem) {
+            if (largura == 0) break;
+            if (fim[t] < 0) largura -= contextos[t]->issueNovaInstrucao(largura);
         }
-        return nullptr;
+        for (size_t t : ordem) contextos[t]->executaInstrucao(); // as unidades de PIPES também vão na ordem da política
+        int cdbs = contextos[0]->config.numCDBs > 0 ? contextos[0]->config.numCDBs : -1;
+        for (size_t t : ordem) {
+            int64_t escritas = contextos[t]->escreveInstrucao(cdbs);
+            if (cdbs > 0) cdbs -= static_cast<int>(escritas);
+        }
+        bool todos = true;
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            if (fim[t] < 0 && contextos[t]->verificaSeJaTerminou()) fim[t] = contextos[t]->clock_cycle;
+            todos = todos && fim[t] >= 0;
+        }
+        return todos;
     }
 
-    std::string verificaUFInstrucao(const InstrucaoDetalhes& instr_details) { //mapeia a operação para a unidade funcional capaz de executá-la
-        const std::string& op = instr_details.operacao;
-        if (op == "ADDD" || op == "SUBD") return "Add";
-        if (op == "MULTD") return "Mult";
-        if (op == "DIVD") return "Div";
-        if (op == "LD") return "Load";
-        if (op == "SD") return "Store";
-        if (op == "ADD" || op == "DADDUI" || op == "BEQ" || op == "BNEZ") return "Integer";
-        std::cerr << "WARN: Unknown operation for UF check: " << op << std::endl;
-        return "";
+    void ordenaContextos() { // round-robin: a prioridade gira a cada ciclo; ICOUNT: menos instruções em voo primeiro
+        size_t n = contextos.size();
+        size_t primeiro = static_cast<size_t>(clock() % static_cast<int64_t>(n));
+        for (size_t i = 0; i < n; ++i) ordem[i] = (primeiro + i) % n;
+        if (politica == PoliticaBusca::Icount) {
+            std::stable_sort(ordem.begin(), ordem.end(), [this](size_t a, size_t b) {
+                return contextos[a]->instrucoesEmVoo() < contextos[b]->instrucoesEmVoo();
+            });
+        }
+    }
+
+    int ciclosOciosos() { // o menor entre os contextos; um contexto travado só volta a andar quando outro libera uma estação
+        int ociosos = -1;
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            if (fim[t] >= 0) continue;
+            int o = contextos[t]->ciclosOciosos();
+            if (o >= 0 && (ociosos < 0 || o < ociosos)) ociosos = o;
+            if (ociosos == 0) return 0;
+        }
+        return ociosos;
     }
+};
 
-    //getUFVazia: retorna ponteiro para a unidade funcional livre
+void escreveSMT(std::ostream& out, FormatoRelatorio formato, PoliticaBusca politica, const ResumoExecucao& total, const std::vector<ResultadoContexto>& contextos) {
+    auto ipc = [](int64_t instrucoes, int64_t ciclos) { return ciclos > 0 ? static_cast<double>(instrucoes) / ciclos : 0.0; };
+    const char* nomePolitica = NOMES_POLITICAS_BUSCA[static_cast<int>(politica)];
+    out << std::fixed << std::setprecision(4);
 
-    UnidadeFuncional* getFUVaziaArithInt(const std::string& tipoFU) { 
-        for (auto& pair : unidadesFuncionais) {
-            if (pair.second.tipoUnidade == tipoFU && !pair.second.ocupado) {
-                return &pair.second;
-            }
+    if (formato == FormatoRelatorio::Texto) {
+        out << "== Simulacao SMT (" << contextos.size() << " contextos, politica " << nomePolitica << ") ==" << '\n';
+        out << "Situacao: " << total.situacao << '\n';
+        out << "Ciclos: " << total.ciclos << '\n';
+        out << "Instrucoes concluidas: " << total.instrucoes << '\n';
+        out << "IPC agregado: " << ipc(total.instrucoes, total.ciclos) << '\n';
+        out << '\n' << std::left << std::setw(10) << "Contexto" << std::setw(11) << "Situacao" << std::setw(12) << "Ciclos"
+            << std::setw(12) << "Instrucoes" << std::setw(8) << "IPC" << "Arquivo" << '\n';
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            const ResultadoContexto& c = contextos[t];
+            out << std::left << std::setw(10) << t << std::setw(11) << c.situacao << std::setw(12) << c.ciclos << std::setw(12) << c.instrucoes
+                << std::setw(8) << ipc(c.instrucoes, c.ciclos) << c.arquivo << '\n';
         }
-        return nullptr;
+    } else if (formato == FormatoRelatorio::Csv) {
+        out << "contexto,arquivo,situacao,ciclos,instrucoes,ipc\n";
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            const ResultadoContexto& c = contextos[t];
+            out << t << ',' << c.arquivo << ',' << c.situacao << ',' << c.ciclos << ',' << c.instrucoes << ',' << ipc(c.instrucoes, c.ciclos) << '\n';
+        }
+        out << "total,," << total.situacao << ',' << total.ciclos << ',' << total.instrucoes << ',' << ipc(total.instrucoes, total.ciclos) << '\n';
+    } else {
+        out << "{\"politica\":" << textoJson(nomePolitica) << ",\"situacao\":" << textoJson(total.situacao) << ",\"ciclos\":" << total.ciclos
+            << ",\"instrucoes\":" << total.instrucoes << ",\"ipc\":" << ipc(total.instrucoes, total.ciclos) << ",\"contextos\":[";
+        for (size_t t = 0; t < contextos.size(); ++t) {
+            const ResultadoContexto& c = contextos[t];
+            out << (t ? "," : "") << "{\"arquivo\":" << textoJson(c.arquivo) << ",\"situacao\":" << textoJson(c.situacao) << ",\"ciclos\":" << c.ciclos
+                << ",\"instrucoes\":" << c.instrucoes << ",\"ipc\":" << ipc(c.instrucoes, c.ciclos) << '}';
+        }
+        out << "]}\n";
     }
+}
 
-    UnidadeFuncionalMemoria* getFUVaziaMem(const std::string& tipoFU) {
-        for (auto& pair : unidadesFuncionaisMemoria) {
-            if (pair.second.tipoUnidade == tipoFU && !pair.second.ocupado) {
-                return &pair.second;
-            }
+// o primeiro arquivo define a máquina; dos outros só vêm as instruções e o bloco DATA
+bool executaSMT(const std::vector<std::string>& arquivos, PoliticaBusca politica, long long cycle_limit, int64_t avanco, FormatoRelatorio formato, std::ostream& out) {
+    std::vector<TraceCompartilhado> traces(arquivos.size());
+    std::vector<std::unique_ptr<Estado>> contextos;
+    std::ostringstream maquina;
+    for (size_t t = 0; t < arquivos.size(); ++t) {
+        if (!traces[t].abre(arquivos[t])) return false;
+        ConfigSimulador config = traces[0].config;
+        config.dados = traces[t].config.dados;
+        std::ostringstream esta;
+        escreveConfig(t == 0 ? maquina : esta, traces[t].config);
+        if (t > 0 && esta.str() != maquina.str()) {
+            std::cerr << "Warning: The CONFIG block of " << arquivos[t] << " differs from " << arquivos[0] << "; using the machine of the first file" << std::endl;
         }
-        return nullptr;
+        contextos.push_back(traces[t].criaSimulador(config));
+        if (avanco > 0) executaAvanco(*contextos.back(), avanco);
     }
+    NucleoSMT nucleo(std::move(contextos), politica);
+    std::string situacao = nucleo.executa(cycle_limit);
+    std::vector<ResultadoContexto> resultados = nucleo.resultados(arquivos, situacao);
+    ResumoExecucao total = {situacao, nucleo.clock(), 0};
+    for (const auto& r : resultados) total.instrucoes += r.instrucoes;
+    escreveSMT(out, formato, politica, total, resultados);
+    return true;
+}
+
+class Barreira { // as threads esperam a última a chegar, que roda a etapa serial antes de liberar todas
+public:
+    explicit Barreira(size_t total) : total(total) {}
 
-    int getCiclos(const InstrucaoDetalhes& instr_details) { //retorna o número de ciclos que a instrução gasta
-        const std::string& op_type = verificaUFInstrucao(instr_details);
-        if (config.ciclos.count(op_type)) {
-            return config.ciclos.at(op_type);
+    template <typename F>
+    void chega(F&& etapaSerial) {
+        std::unique_lock<std::mutex> g(trava);
+        uint64_t minha = geracao;
+        if (++chegadas == total) {
+            etapaSerial();
+            chegadas = 0;
+            geracao++;
+            liberacao.notify_all();
+            return;
         }
-        std::cerr << "Error: Cycle count not found for FU type '" << op_type
-                  << "' derived from operation '" << instr_details.operacao << "'" << std::endl;
-        return 1;
+        liberacao.wait(g, [&] { return geracao != minha; });
     }
 
+private:
+    std::mutex trava;
+    std::condition_variable liberacao;
+    size_t total;
+    size_t chegadas = 0;
+    uint64_t geracao = 0;
+};
+
+struct ResultadoMultinucleo {
+    std::vector<ResultadoContexto> nucleos;
+    ResumoExecucao total;
+    unsigned threads = 0;
+    int64_t quanta = 0;
+    int64_t acessosLLC = 0, faltasLLC = 0, devolucoesLLC = 0;
+    double segundos = 0;
 
-    void alocaFU(UnidadeFuncional& uf, const InstrucaoDetalhes& instr_details, EstadoInstrucao& estado_instr_orig) { // aloca uma unidade funcional para a instrução
-        uf.instrucao_details = instr_details;
-        uf.estadoInstrucaoOriginal = &estado_instr_orig;
-        uf.tempo = getCiclos(instr_details) + 1;
-        uf.ocupado = true;
-        uf.operacao = instr_details.operacao;
-        uf.vj = std::nullopt;
-        uf.vk = std::nullopt;
-        uf.qj = std::nullopt;
-        uf.qk = std::nullopt;
+    uint64_t assinatura() const { // resume os resultados simulados (não o tempo de execução) para comparar execuções
+        uint64_t h = misturaBits(static_cast<uint64_t>(total.ciclos));
+        for (const auto& n : nucleos) h = misturaBits(h ^ misturaBits(static_cast<uint64_t>(n.ciclos)) ^ static_cast<uint64_t>(n.instrucoes));
+        for (int64_t v : {acessosLLC, faltasLLC, devolucoesLLC}) h = misturaBits(h ^ static_cast<uint64_t>(v));
+        return h;
+    }
+};
 
-        std::string src_reg_j_name, src_reg_k_name;
+// multinúcleo: um Estado por núcleo, cada um com a sua L1 (L1D_SIZE com FUNCTIONAL 1) e a LLC compartilhada. Os
+// núcleos são repartidos entre as threads e rodam quantum ciclos; na barreira, a última thread aplica as filas à LLC.
+// Dentro de um quantum um núcleo não vê as faltas dos outros; com o mesmo quantum, o resultado é sempre o mesmo
+ResultadoMultinucleo simulaMultinucleo(const ConfigSimulador& maquina, const std::vector<const TraceCompartilhado*>& traces,
+                                       const std::vector<std::string>& arquivos, unsigned numThreads, int64_t quantum, long long cycle_limit, int64_t avanco) {
+    auto inicio = std::chrono::steady_clock::now();
+    size_t n = traces.size();
+    CacheCompartilhada llc(maquina);
+    ConfigSimulador configNucleo = maquina;
+    configNucleo.tamanhoL2 = 0; // a L2 da configuração é a LLC
+    std::vector<std::unique_ptr<Estado>> nucleos;
+    std::vector<PortaLLC> portas(n);
+    std::vector<std::vector<RequisicaoLLC>*> filas;
+    for (size_t i = 0; i < n; ++i) {
+        ConfigSimulador c = configNucleo;
+        c.dados = traces[i]->config.dados;
+        nucleos.push_back(traces[i]->criaSimulador(c));
+        portas[i].llc = &llc;
+        portas[i].espaco = static_cast<uint64_t>(i) << 48;
+        filas.push_back(&portas[i].fila);
+        nucleos[i]->conectaLLC(portas[i]);
+        if (avanco > 0) executaAvanco(*nucleos[i], avanco);
+    }
+    llc.aplica(filas); // aquecimento do avanço funcional
 
-        if (instr_details.operacao == "ADDD" || instr_details.operacao == "SUBD") {
-            if (uf.tempo.has_value() && uf.tempo.value() > 0) {
-                uf.tempo = uf.tempo.value() - 1;
+    ResultadoMultinucleo r;
+    r.threads = static_cast<unsigned>(std::min<size_t>(std::max(numThreads, 1u), n));
+    std::vector<std::string> situacoes(n); // vazia enquanto o núcleo roda
+    int64_t fimQuantum = cycle_limit > 0 ? std::min<int64_t>(quantum, cycle_limit) : quantum;
+    bool continua = true;
+    Barreira barreira(r.threads);
+    auto trabalho = [&](size_t thread) {
+        while (true) {
+            for (size_t i = thread; i < n; i += r.threads) {
+                if (!situacoes[i].empty()) continue;
+                std::string situacao = executaEmLote(*nucleos[i], fimQuantum);
+                if (situacao != "limite") situacoes[i] = situacao;
             }
+            barreira.chega([&] {
+                llc.aplica(filas);
+                r.quanta++;
+                bool rodando = std::any_of(situacoes.begin(), situacoes.end(), [](const std::string& s) { return s.empty(); });
+                continua = rodando && (cycle_limit == 0 || fimQuantum < cycle_limit);
+                fimQuantum += quantum;
+                if (cycle_limit > 0) fimQuantum = std::min<int64_t>(fimQuantum, cycle_limit);
+            });
+            if (!continua) return;
         }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < r.threads; ++t) threads.emplace_back(trabalho, t);
+    trabalho(0);
+    for (auto& th : threads) th.join();
 
-        if (instr_details.operacao == "BNEZ" || instr_details.operacao == "BEQ") {
-            src_reg_j_name = instr_details.registradorR;
-            src_reg_k_name = instr_details.registradorS;
-        } else {
-            src_reg_j_name = instr_details.registradorS;
-            src_reg_k_name = instr_details.registradorT;
-        }
+    r.total = {"concluida", 0, 0};
+    for (size_t i = 0; i < n; ++i) {
+        std::string situacao = situacoes[i].empty() ? "limite" : situacoes[i];
+        r.nucleos.push_back({arquivos[i], situacao, nucleos[i]->clock_cycle, nucleos[i]->instrucoesConcluidas()});
+        r.total.ciclos = std::max(r.total.ciclos, nucleos[i]->clock_cycle);
+        r.total.instrucoes += nucleos[i]->instrucoesConcluidas();
+        if (situacao != "concluida" && r.total.situacao != "limite") r.total.situacao = situacao;
+    }
+    r.acessosLLC = llc.acessos;
+    r.faltasLLC = llc.faltas;
+    r.devolucoesLLC = llc.devolucoes;
+    r.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    return r;
+}
 
-        auto setup_operand = [&](std::optional<std::string>& v_val, std::optional<std::string>& q_val, const std::string& reg_name) {
-            if (reg_name.empty()) {
-                v_val = "N/A";
-                return;
-            }
-            bool is_immediate = true;
-            if (reg_name.empty() || (!reg_name.empty() && (reg_name[0] == 'F' || reg_name[0] == 'R'))) {
-                is_immediate = false;
-                for(char c : reg_name)
-                    if (reg_name.length() > 1 && isalpha(c) && c != 'F' && c != 'R')
-                        is_immediate = true;
-            }
+std::string textoAssinatura(uint64_t h) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return ss.str();
+}
 
-            if (is_immediate && !(reg_name[0] == 'F' || reg_name[0] == 'R')) {
-                v_val = reg_name;
-            } else if (estacaoRegistradores.count(reg_name)) {
-                const auto& reg_status = estacaoRegistradores.at(reg_name);
-                if (!reg_status.has_value() || reg_status.value().rfind("VAL(", 0) == 0) {
-                    v_val = reg_status.has_value() ? reg_status.value() : reg_name;
-                } else {
-                    const std::string& producing_fu_name = reg_status.value();
-                    if (unidadesFuncionais.count(producing_fu_name) || unidadesFuncionaisMemoria.count(producing_fu_name)) {
-                        q_val = producing_fu_name;
-                    } else {
-                        v_val = producing_fu_name;
-                    }
-                }
-            } else {
-                v_val = reg_name;
-            }
-        };
+void escreveMultinucleo(std::ostream& out, FormatoRelatorio formato, const ResultadoMultinucleo& r, int64_t quantum) {
+    auto ipc = [](int64_t instrucoes, int64_t ciclos) { return ciclos > 0 ? static_cast<double>(instrucoes) / ciclos : 0.0; };
+    int64_t ciclosNucleo = 0; // soma dos ciclos simulados de todos os núcleos
+    for (const auto& n : r.nucleos) ciclosNucleo += n.ciclos;
+    double porSegundo = r.segundos > 0 ? ciclosNucleo / r.segundos : 0.0;
+    out << std::fixed << std::setprecision(4);
 
-        setup_operand(uf.vj, uf.qj, src_reg_j_name);
-        setup_operand(uf.vk, uf.qk, src_reg_k_name);
-    }
-
-    void alocaFuMem(UnidadeFuncionalMemoria& uf_mem, const InstrucaoDetalhes& instr_details, EstadoInstrucao& estado_instr_orig) { // aloca uma unidade funcional para a instrução
-        uf_mem.instrucao_details = instr_details;
-        uf_mem.estadoInstrucaoOriginal = &estado_instr_orig;
-        uf_mem.tempo = getCiclos(instr_details) + 1;
-        uf_mem.ocupado = true;
-        uf_mem.operacao = instr_details.operacao;
-        uf_mem.endereco = instr_details.registradorS + "+" + instr_details.registradorT;
-        uf_mem.destino = instr_details.registradorR;
-        uf_mem.qi = std::nullopt;
-        uf_mem.qj = std::nullopt;
-
-        if (instr_details.operacao == "SD") {
-            if (estacaoRegistradores.count(instr_details.registradorR)) {
-                const auto& producing_fu_name_opt = estacaoRegistradores.at(instr_details.registradorR);
-                if (producing_fu_name_opt.has_value()) {
-                    const std::string& producing_fu_name = producing_fu_name_opt.value();
-                    if (unidadesFuncionais.count(producing_fu_name) || unidadesFuncionaisMemoria.count(producing_fu_name)) {
-                        uf_mem.qi = producing_fu_name;
-                    }
-                }
-            }
+    if (formato == FormatoRelatorio::Texto) {
+        out << "== Simulacao Multinucleo (" << r.nucleos.size() << " nucleos, quantum " << quantum << ", " << r.threads << " threads) ==" << '\n';
+        out << "Situacao: " << r.total.situacao << '\n';
+        out << "Ciclos: " << r.total.ciclos << '\n';
+        out << "Instrucoes concluidas: " << r.total.instrucoes << '\n';
+        out << "IPC agregado: " << ipc(r.total.instrucoes, r.total.ciclos) << '\n';
+        out << "LLC: " << r.acessosLLC << " acessos, " << r.faltasLLC << " faltas, " << r.devolucoesLLC << " devolucoes" << '\n';
+        out << "Quanta: " << r.quanta << '\n';
+        out << "Tempo: " << r.segundos << " s (" << std::setprecision(0) << porSegundo << " ciclos de nucleo/s)" << std::setprecision(4) << '\n';
+        out << "Assinatura: " << textoAssinatura(r.assinatura()) << '\n';
+        out << '\n' << std::left << std::setw(8) << "Nucleo" << std::setw(11) << "Situacao" << std::setw(12) << "Ciclos"
+            << std::setw(12) << "Instrucoes" << std::setw(8) << "IPC" << "Arquivo" << '\n';
+        for (size_t i = 0; i < r.nucleos.size(); ++i) {
+            const ResultadoContexto& n = r.nucleos[i];
+            out << std::left << std::setw(8) << i << std::setw(11) << n.situacao << std::setw(12) << n.ciclos << std::setw(12) << n.instrucoes
+                << std::setw(8) << ipc(n.instrucoes, n.ciclos) << n.arquivo << '\n';
+        }
+    } else if (formato == FormatoRelatorio::Csv) {
+        out << "nucleo,arquivo,situacao,ciclos,instrucoes,ipc\n";
+        for (size_t i = 0; i < r.nucleos.size(); ++i) {
+            const ResultadoContexto& n = r.nucleos[i];
+            out << i << ',' << n.arquivo << ',' << n.situacao << ',' << n.ciclos << ',' << n.instrucoes << ',' << ipc(n.instrucoes, n.ciclos) << '\n';
+        }
+        out << "total,," << r.total.situacao << ',' << r.total.ciclos << ',' << r.total.instrucoes << ',' << ipc(r.total.instrucoes, r.total.ciclos) << '\n';
+    } else {
+        out << "{\"nucleos\":" << r.nucleos.size() << ",\"quantum\":" << quantum << ",\"threads\":" << r.threads << ",\"situacao\":" << textoJson(r.total.situacao)
+            << ",\"ciclos\":" << r.total.ciclos << ",\"instrucoes\":" << r.total.instrucoes << ",\"ipc\":" << ipc(r.total.instrucoes, r.total.ciclos)
+            << ",\"llc\":{\"acessos\":" << r.acessosLLC << ",\"faltas\":" << r.faltasLLC << ",\"devolucoes\":" << r.devolucoesLLC << '}'
+            << ",\"quanta\":" << r.quanta << ",\"segundos\":" << r.segundos << ",\"assinatura\":" << textoJson(textoAssinatura(r.assinatura())) << ",\"porNucleo\":[";
+        for (size_t i = 0; i < r.nucleos.size(); ++i) {
+            const ResultadoContexto& n = r.nucleos[i];
+            out << (i ? "," : "") << "{\"arquivo\":" << textoJson(n.arquivo) << ",\"situacao\":" << textoJson(n.situacao) << ",\"ciclos\":" << n.ciclos
+                << ",\"instrucoes\":" << n.instrucoes << ",\"ipc\":" << ipc(n.instrucoes, n.ciclos) << '}';
         }
+        out << "]}\n";
+    }
+}
 
-        if (estacaoRegistradores.count(instr_details.registradorT)) {
-            const auto& producing_fu_name_opt = estacaoRegistradores.at(instr_details.registradorT);
-            if (producing_fu_name_opt.has_value()) {
-                const std::string& producing_fu_name = producing_fu_name_opt.value();
-                if (unidadesFuncionais.count(producing_fu_name) || unidadesFuncionaisMemoria.count(producing_fu_name)) {
-                    uf_mem.qj = producing_fu_name;
-                }
-            }
+void escreveEscala(std::ostream& out, FormatoRelatorio formato, const std::vector<ResultadoMultinucleo>& rodadas) { // uma linha por número de threads
+    out << std::fixed << std::setprecision(4);
+    auto aceleracao = [&](const ResultadoMultinucleo& r) { return r.segundos > 0 ? rodadas[0].segundos / r.segundos : 0.0; };
+    auto identico = [&](const ResultadoMultinucleo& r) { return r.assinatura() == rodadas[0].assinatura(); };
+    if (formato == FormatoRelatorio::Texto) {
+        out << std::left << std::setw(9) << "Threads" << std::setw(12) << "Tempo(s)" << std::setw(12) << "Aceleracao" << std::setw(19) << "Assinatura" << "Identico" << '\n';
+        for (const auto& r : rodadas) {
+            out << std::left << std::setw(9) << r.threads << std::setw(12) << r.segundos << std::setw(12) << aceleracao(r)
+                << std::setw(19) << textoAssinatura(r.assinatura()) << (identico(r) ? "Sim" : "Nao") << '\n';
         }
+    } else if (formato == FormatoRelatorio::Csv) {
+        out << "threads,segundos,aceleracao,assinatura,identico\n";
+        for (const auto& r : rodadas) {
+            out << r.threads << ',' << r.segundos << ',' << aceleracao(r) << ',' << textoAssinatura(r.assinatura()) << ',' << (identico(r) ? 1 : 0) << '\n';
+        }
+    } else {
+        out << '[';
+        for (size_t i = 0; i < rodadas.size(); ++i) {
+            const auto& r = rodadas[i];
+            out << (i ? "," : "") << "{\"threads\":" << r.threads << ",\"segundos\":" << r.segundos << ",\"aceleracao\":" << aceleracao(r)
+                << ",\"assinatura\":" << textoJson(textoAssinatura(r.assinatura())) << ",\"identico\":" << (identico(r) ? "true" : "false") << '}';
+        }
+        out << "]\n";
     }
+}
 
-    void escreveEstacaoRegistrador(const InstrucaoDetalhes& instr_details, const std::string& ufNome) { //informa ao registrador final qual unidade funcional irá lhe entregar o resultado da operação
-        if (instr_details.operacao != "SD" && instr_details.operacao != "BEQ" && instr_details.operacao != "BNEZ") {
-            if (!instr_details.registradorR.empty()) {
-                estacaoRegistradores[instr_details.registradorR] = ufNome;
-            }
+// o primeiro arquivo define a máquina; com numNucleos maior que a lista, os arquivos se repetem em ordem. Com escala,
+// roda uma vez para cada número de threads e compara as assinaturas
+bool executaMultinucleo(std::vector<std::string> arquivos, size_t numNucleos, unsigned numThreads, const std::vector<unsigned>& escala, int64_t quantum,
+                        long long cycle_limit, int64_t avanco, FormatoRelatorio formato, std::ostream& out) {
+    std::map<std::string, TraceCompartilhado> abertos; // cada arquivo é lido uma vez, mesmo repetido em vários núcleos
+    for (const auto& a : arquivos) {
+        if (abertos.count(a)) continue;
+        if (!abertos[a].abre(a)) return false;
+    }
+    const ConfigSimulador& maquina = abertos[arquivos[0]].config;
+    if (maquina.tamanhoL1 == 0 || !maquina.funcional) {
+        std::cerr << "Warning: Without L1D_SIZE and FUNCTIONAL 1 the cores do not access the shared LLC and run independently" << std::endl;
+    }
+    std::ostringstream textoMaquina;
+    escreveConfig(textoMaquina, maquina);
+    for (const auto& e : abertos) {
+        std::ostringstream esta;
+        escreveConfig(esta, e.second.config);
+        if (esta.str() != textoMaquina.str()) {
+            std::cerr << "Warning: The CONFIG block of " << e.first << " differs from " << arquivos[0] << "; using the machine of the first file" << std::endl;
         }
     }
+    size_t distintos = arquivos.size();
+    for (size_t i = distintos; i < numNucleos; ++i) arquivos.push_back(arquivos[i % distintos]);
+    std::vector<const TraceCompartilhado*> traces;
+    for (const auto& a : arquivos) traces.push_back(&abertos[a]);
+
+    if (escala.empty()) {
+        escreveMultinucleo(out, formato, simulaMultinucleo(maquina, traces, arquivos, numThreads, quantum, cycle_limit, avanco), quantum);
+        return true;
+    }
+    std::vector<ResultadoMultinucleo> rodadas;
+    for (unsigned t : escala) rodadas.push_back(simulaMultinucleo(maquina, traces, arquivos, t, quantum, cycle_limit, avanco));
+    escreveEscala(out, formato, rodadas);
+    return true;
+}
 
-    
+int executaCheckpoint(int argc, char* argv[]) { // --checkpoint <entrada> <saida.ckp> [--avanca N] [--ciclos C] [--stream]
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " --checkpoint <input_file.txt|input_file.trc> <saida.ckp> [--avanca N] [--ciclos C] [--stream]" << std::endl;
+        return 1;
+    }
+    std::string entrada = argv[2], saida = argv[3];
+    int64_t avanco = 0;
+    long long ciclos = 0;
+    bool streaming = false;
+    for (int i = 4; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--avanca" && i + 1 < argc) {
+            avanco = std::atoll(argv[++i]);
+        } else if (arg == "--ciclos" && i + 1 < argc) {
+            ciclos = std::atoll(argv[++i]);
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else {
+            std::cerr << "Warning: Unknown argument '" << arg << "'" << std::endl;
+        }
+    }
+    ConfigSimulador config;
+    std::unique_ptr<Estado> estado = carregaSimulador(entrada, streaming, config);
+    if (!estado) return 1;
+    if (avanco > 0) executaAvanco(*estado, avanco);
+    std::string situacao = ciclos > 0 ? executaEmLote(*estado, ciclos) : "limite";
+    if (!gravaCheckpoint(saida, *estado)) return 1;
+    std::cout << "Checkpoint gravado em " << saida << ": ciclo " << estado->clock_cycle << ", " << estado->instrucoesConcluidas()
+              << " instrucoes concluidas (simulacao " << situacao << ")" << std::endl;
+    return 0;
+}
 
-    void liberaUFEsperandoResultado(const std::string& nomeUFQueTerminou) { //libera dependeências que estavam esperando a liberação da unidade funcional
-        std::string val_representation = "VAL(" + nomeUFQueTerminou + ")";
+long picoMemoriaKB() { // pico de memória residente do processo, -1 se indisponível
+#if defined(__APPLE__)
+    struct rusage uso;
+    return getrusage(RUSAGE_SELF, &uso) == 0 ? uso.ru_maxrss / 1024 : -1;
+#elif defined(__unix__)
+    struct rusage uso;
+    return getrusage(RUSAGE_SELF, &uso) == 0 ? uso.ru_maxrss : -1;
+#else
+    return -1;
+#endif
+}
 
-        for (auto& pair : unidadesFuncionais) {
-            UnidadeFuncional& uf_esperando = pair.second;
-            if (uf_esperando.ocupado) {
-                bool qj_cleared_by_this_fu = false;
-                bool qk_cleared_by_this_fu = false;
+// alocações da thread, contadas só enquanto o --benchmark mede o ciclo de simulação depois do aquecimento; nos demais
+// modos o custo é o teste de uma variável da própria thread, sem estado compartilhado entre as threads
+thread_local bool contaAlocacoes = false;
+thread_local uint64_t alocacoes = 0;
 
-                if (uf_esperando.qj.has_value() && uf_esperando.qj.value() == nomeUFQueTerminou) {
-                    uf_esperando.vj = val_representation;
-                    uf_esperando.qj = std::nullopt;
-                    qj_cleared_by_this_fu = true;
-                }
-                if (uf_esperando.qk.has_value() && uf_esperando.qk.value() == nomeUFQueTerminou) {
-                    uf_esperando.vk = val_representation;
-                    uf_esperando.qk = std::nullopt;
-                    qk_cleared_by_this_fu = true;
-                }
+void* operator new(std::size_t n) {
+    if (contaAlocacoes) alocacoes++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
 
-                if ((qj_cleared_by_this_fu || qk_cleared_by_this_fu) &&
-                    !uf_esperando.qj.has_value() && !uf_esperando.qk.has_value()) {
-                    if (uf_esperando.tempo.has_value() && uf_esperando.tempo.value() > 0) {
-                        uf_esperando.tempo = uf_esperando.tempo.value() - 1;
-                    }
-                }
-            }
-        }
+// fora de linha: com o delete expandido no chamador o GCC acusa free() sobre ponteiro de new
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
 
-        for (auto& pair : unidadesFuncionaisMemoria) {
-            UnidadeFuncionalMemoria& uf_mem_esperando = pair.second;
-            if (uf_mem_esperando.ocupado) {
-                bool dependency_resolved_by_this_fu_for_mem = false;
+constexpr int64_t CICLOS_AQUECIMENTO = 1000; // tabelas, páginas e vetores de trabalho atingem o tamanho final
 
-                if (uf_mem_esperando.qi.has_value() && uf_mem_esperando.qi.value() == nomeUFQueTerminou) {
-                    uf_mem_esperando.qi = std::nullopt;
-                    dependency_resolved_by_this_fu_for_mem = true;
-                }
-                else if (uf_mem_esperando.qj.has_value() && uf_mem_esperando.qj.value() == nomeUFQueTerminou) {
-                    uf_mem_esperando.qj = std::nullopt;
-                    dependency_resolved_by_this_fu_for_mem = true;
-                }
+struct CasoBenchmark {
+    const char* nome;
+    const char* mix; // nullptr: mix padrão
+    double distancia;
+    int estacoes;    // 0: UNITS da configuração; N: N estações de Add e de Mult (o custo por ciclo deve seguir as ocupadas, não N)
+    void (*ajusta)(ConfigSimulador&); // ROB, LSQ, caches ou PIPES sobre a configuração; nullptr se nenhum
+};
 
-                if (dependency_resolved_by_this_fu_for_mem) {
-                    if (uf_mem_esperando.tempo.has_value() && uf_mem_esperando.tempo.value() > 0) {
-                        uf_mem_esperando.tempo = uf_mem_esperando.tempo.value() - 1;
-                    }
-                }
-            }
+// conjunto padrão; com --mix ou --distancia roda só o caso pedido
+const CasoBenchmark CASOS_BENCHMARK[] = {
+    {"misto",         nullptr,                      4,  0,    nullptr},
+    {"serial",        nullptr,                      1,  0,    nullptr},
+    {"paralelo",      nullptr,                      12, 0,    nullptr},
+    {"memoria",       "load=45,store=35,int=20",    4,  0,    nullptr},
+    {"divisao",       "add=40,mul=30,div=30",       4,  0,    nullptr},
+    {"estacoes-16",   nullptr,                      4,  16,   nullptr},
+    {"estacoes-512",  nullptr,                      4,  512,  nullptr},
+    {"estacoes-4096", nullptr,                      4,  4096, nullptr},
+    {"rob",           nullptr,                      4,  0,    [](ConfigSimulador& c) { c.tamanhoROB = 32; c.preditor = 2; }},
+    {"lsq",           "load=45,store=35,int=20",    4,  0,    [](ConfigSimulador& c) { c.tamanhoROB = 32; c.modoLSQ = 3; }},
+    {"cache",         "load=40,store=25,int=20,add=15", 4, 0, [](ConfigSimulador& c) { c.funcional = 1; c.tamanhoL1 = 4096; c.tamanhoL2 = 65536; }},
+    {"pipes",         "add=40,mul=40,int=20",       4,  0,    [](ConfigSimulador& c) { c.pipelines["Add"] = {1, 1}; c.pipelines["Mult"] = {2, 1}; }},
+};
+
+struct ExecucaoBenchmark {
+    std::string nome;
+    ParametrosSinteticos params;
+    ConfigSimulador config;
+};
+
+void executaBenchmark(const std::vector<ExecucaoBenchmark>& casos, std::ostream& out) {
+    out << std::left << std::setw(15) << "Caso" << std::setw(12) << "Instrucoes" << std::setw(12) << "Ciclos" << std::setw(10) << "Tempo(s)"
+        << std::setw(14) << "Instr/s" << std::setw(14) << "Ciclos/s" << std::setw(12) << "Alocacoes" << "RSS pico (KB)" << std::endl;
+    for (const auto& caso : casos) {
+        auto fonte = std::make_unique<FonteSintetica>(caso.config, caso.params);
+        auto programa = fonte->programa;
+        Estado simulador(caso.config, programa, std::move(fonte));
+        auto inicio = std::chrono::steady_clock::now();
+        bool terminou = false;
+        while (!terminou && simulador.clock_cycle < CICLOS_AQUECIMENTO) terminou = simulador.executa_ciclo();
+        uint64_t alocacoesAntes = alocacoes;
+        contaAlocacoes = true;
+        std::string situacao = terminou ? "concluida" : executaEmLote(simulador, 0);
+        contaAlocacoes = false;
+        uint64_t alocacoesMedidas = alocacoes - alocacoesAntes; // depois do aquecimento
+        double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+        double s = segundos > 0 ? segundos : 1e-9;
+        out << std::left << std::setw(15) << caso.nome << std::setw(12) << simulador.instrucoesConcluidas() << std::setw(12) << simulador.clock_cycle
+            << std::fixed << std::setprecision(3) << std::setw(10) << segundos << std::setprecision(0)
+            << std::setw(14) << simulador.instrucoesConcluidas() / s << std::setw(14) << simulador.clock_cycle / s
+            << std::setw(12) << alocacoesMedidas << picoMemoriaKB();
+        if (situacao != "concluida") out << " (" << situacao << ")";
+        out << std::endl;
+    }
+}
+
+int executaSintetico(int argc, char* argv[]) { // --gera <saida.txt> [opcoes] | --benchmark [opcoes]
+    std::string comando = argv[1];
+    int i = 2;
+    std::string saida;
+    if (comando == "--gera") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --gera <saida.txt> [--tamanho N] [--mix add=30,...] [--distancia D] [--semente S] [--config input.txt]" << std::endl;
+            return 1;
+        }
+        saida = argv[i++];
+    }
+    ParametrosSinteticos params;
+    ConfigSimulador config = configSintetica();
+    bool personalizado = false;
+    for (; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tamanho" && i + 1 < argc) {
+            params.tamanho = std::atoll(argv[++i]);
+        } else if (arg == "--mix" && i + 1 < argc) {
+            if (!parseMix(argv[++i], params)) return 1;
+            personalizado = true;
+        } else if (arg == "--distancia" && i + 1 < argc) {
+            params.distancia = std::atof(argv[++i]);
+            personalizado = true;
+        } else if (arg == "--semente" && i + 1 < argc) {
+            params.semente = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--config" && i + 1 < argc) {
+            config = ConfigSimulador();
+            LeitorTrace leitor;
+            if (!leitor.abre(argv[++i], config)) return 1;
+        } else {
+            std::cerr << "Warning: Unknown argument '" << arg << "'" << std::endl;
         }
     }
 
-    //limpeza das instruções e mudança dos status da unidades funcionais
+    if (comando == "--gera") return escreveTraceSintetico(saida, config, params) ? 0 : 1;
 
-    void desalocaUFMem(UnidadeFuncionalMemoria& uf_mem) {
-        uf_mem.instrucao_details = std::nullopt;
-        uf_mem.estadoInstrucaoOriginal = nullptr;
-        uf_mem.tempo = std::nullopt;
-        uf_mem.ocupado = false;
-        uf_mem.operacao = std::nullopt;
-        uf_mem.endereco = std::nullopt;
-        uf_mem.destino = std::nullopt;
-        uf_mem.qi = std::nullopt;
-        uf_mem.qj = std::nullopt;
-    }
-
-    void desalocaUF(UnidadeFuncional& uf) {
-        uf.instrucao_details = std::nullopt;
-        uf.estadoInstrucaoOriginal = nullptr;
-        uf.tempo = std::nullopt;
-        uf.ocupado = false;
-        uf.operacao = std::nullopt;
-        uf.vj = std::nullopt;
-        uf.vk = std::nullopt;
-        uf.qj = std::nullopt;
-        uf.qk = std::nullopt;
+    std::vector<ExecucaoBenchmark> casos;
+    if (personalizado) {
+        casos.push_back({"personalizado", params, config});
+    } else {
+        for (const auto& c : CASOS_BENCHMARK) {
+            ExecucaoBenchmark e = {c.nome, params, config};
+            if (c.mix) parseMix(c.mix, e.params);
+            e.params.distancia = c.distancia;
+            if (c.estacoes > 0) e.config.unidades["Add"] = e.config.unidades["Mult"] = c.estacoes;
+            if (c.ajusta) c.ajusta(e.config);
+            casos.push_back(e);
+        }
     }
+    executaBenchmark(casos, std::cout);
+    return 0;
+}
 
-    bool verificaSeJaTerminou() { //retorna true se todas as instruções do arquivo de entrada tiverem escrito seus resultados
-        if (estadoInstrucoes.empty()) return true;
-        for (const auto& instr_state : estadoInstrucoes) {
-            if (!instr_state.write.has_value()) {
-                return false;
+int main(int argc, char* argv[]) { //leitura do arquivo principal, criação do simulador, decisão de execução do algoritmo e executa todas as instruções
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input_file.txt|input_file.trc> [run] [opcoes]" << std::endl;
+        std::cerr << "       " << argv[0] << " --converte <input_file.txt> <saida.trc>" << std::endl;
+        std::cerr << "       " << argv[0] << " --checkpoint <input_file.txt|input_file.trc> <saida.ckp> [opcoes]" << std::endl;
+        std::cerr << "       " << argv[0] << " --gera <saida.txt> [opcoes]" << std::endl;
+        std::cerr << "       " << argv[0] << " --benchmark [opcoes]" << std::endl;
+        return 1;
+    }
+    std::string filename = argv[1];
+    if (filename == "--converte") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --converte <input_file.txt> <saida.trc>" << std::endl;
+            return 1;
+        }
+        return converteTrace(argv[2], argv[3]) ? 0 : 1;
+    }
+    if (filename == "--checkpoint") {
+        return executaCheckpoint(argc, argv);
+    }
+    if (filename == "--gera" || filename == "--benchmark") {
+        return executaSintetico(argc, argv);
+    }
+
+    char step_mode = 's';
+    bool salta_ociosos = false;
+    bool streaming = false;
+    bool quieto = false;
+    bool lista_instrucoes = true;
+    bool estatisticas = false;
+    std::string arquivo_eventos;
+    size_t capacidade_eventos = 1 << 20;
+    FormatoRelatorio formato = FormatoRelatorio::Texto;
+    std::string arquivo_resultados, arquivo_saida;
+    long long cycle_limit = 0; // 0: sem limite; a simulação para sozinha se travar
+    int64_t avanco = 0;        // instruções só no modelo funcional antes do primeiro ciclo
+    std::string arquivo_checkpoint;
+    int64_t snapshot_a_cada = 0;
+    std::vector<int64_t> snapshots_em;
+    std::vector<FaixaVarredura> faixas;
+    bool lockstep = true; // varredura: configurações compatíveis em lotes no MotorLockstep
+    bool especializados = true; // configurações de uma forma registrada rodam no seu NucleoFixo
+    ParametrosAmostragem amostragem;
+    std::vector<std::string> arquivos_smt; // contextos além do arquivo principal
+    PoliticaBusca politica = PoliticaBusca::RoundRobin;
+    std::vector<std::string> arquivos_nucleos; // núcleos além do arquivo principal
+    size_t num_nucleos = 0;
+    int64_t quantum = 1000;
+    std::vector<unsigned> escala;
+    std::string arquivo_incremental;
+    int64_t intervalo_incremental = 1000;
+    unsigned num_threads = std::thread::hardware_concurrency();
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "run") {
+            step_mode = 'r';
+        } else if (arg == "--salto") {
+            salta_ociosos = true;
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--quieto") {
+            quieto = true;
+        } else if (arg == "--sem-instrucoes") {
+            lista_instrucoes = false;
+        } else if (arg == "--estatisticas") {
+            estatisticas = true;
+        } else if (arg == "--eventos" && i + 1 < argc) {
+            arquivo_eventos = argv[++i];
+        } else if (arg == "--capacidade-eventos" && i + 1 < argc) {
+            capacidade_eventos = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--limite" && i + 1 < argc) {
+            cycle_limit = std::atoll(argv[++i]);
+        } else if (arg == "--avanca" && i + 1 < argc) {
+            avanco = std::atoll(argv[++i]);
+        } else if (arg == "--restaura" && i + 1 < argc) {
+            arquivo_checkpoint = argv[++i];
+        } else if (arg == "--resultados" && i + 1 < argc) {
+            arquivo_resultados = argv[++i];
+        } else if (arg == "--saida" && i + 1 < argc) {
+            arquivo_saida = argv[++i];
+        } else if (arg == "--formato" && i + 1 < argc) {
+            std::string f = argv[++i];
+            if (f == "csv") formato = FormatoRelatorio::Csv;
+            else if (f == "json") formato = FormatoRelatorio::Json;
+            else if (f != "texto") std::cerr << "Warning: Unknown format '" << f << "', using texto" << std::endl;
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshot_a_cada = std::atoll(argv[++i]);
+        } else if (arg == "--snapshot-em" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string ciclo;
+            while (std::getline(ss, ciclo, ',')) snapshots_em.push_back(std::atoll(ciclo.c_str()));
+            std::sort(snapshots_em.begin(), snapshots_em.end());
+        } else if (arg == "--varredura" && i + 1 < argc) {
+            FaixaVarredura faixa;
+            if (!parseFaixa(argv[++i], faixa)) return 1;
+            faixas.push_back(faixa);
+        } else if (arg == "--amostragem" && i + 1 < argc) {
+            amostragem.intervalo = std::atoll(argv[++i]);
+            if (amostragem.intervalo <= 0) {
+                std::cerr << "Error: --amostragem needs a positive interval length" << std::endl;
+                return 1;
             }
+        } else if (arg == "--grupos" && i + 1 < argc) {
+            amostragem.grupos = std::atoi(argv[++i]);
+        } else if (arg == "--amostras" && i + 1 < argc) {
+            amostragem.amostrasPorGrupo = std::atoi(argv[++i]);
+        } else if (arg == "--aquecimento" && i + 1 < argc) {
+            amostragem.aquecimento = std::atoll(argv[++i]);
+        } else if (arg == "--semente" && i + 1 < argc) {
+            amostragem.semente = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--smt" && i + 1 < argc) {
+            arquivos_smt.push_back(argv[++i]);
+        } else if (arg == "--politica" && i + 1 < argc) {
+            std::string p = argv[++i];
+            if (p == "icount") politica = PoliticaBusca::Icount;
+            else if (p != "rr") std::cerr << "Warning: Unknown fetch policy '" << p << "', using rr" << std::endl;
+        } else if (arg == "--nucleo" && i + 1 < argc) {
+            arquivos_nucleos.push_back(argv[++i]);
+        } else if (arg == "--nucleos" && i + 1 < argc) {
+            num_nucleos = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--quantum" && i + 1 < argc) {
+            quantum = std::atoll(argv[++i]);
+            if (quantum <= 0) {
+                std::cerr << "Error: --quantum needs a positive number of cycles" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--escala" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string t;
+            while (std::getline(ss, t, ',')) escala.push_back(static_cast<unsigned>(std::max(std::atoi(t.c_str()), 1)));
+        } else if (arg == "--incremental" && i + 1 < argc) {
+            arquivo_incremental = argv[++i];
+        } else if (arg == "--intervalo-incremental" && i + 1 < argc) {
+            intervalo_incremental = std::atoll(argv[++i]);
+            if (intervalo_incremental <= 0) {
+                std::cerr << "Error: --intervalo-incremental needs a positive number of cycles" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sem-lockstep") {
+            lockstep = false;
+        } else if (arg == "--sem-especializados") {
+            especializados = false;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Warning: Unknown argument '" << arg << "'" << std::endl;
         }
-        return true;
     }
 
-    void issueNovaInstrucao() { //busca a nova instrução, procura uma unidade funcional para alocá-la e marca o ciclo de emissão da instrução
-        EstadoInstrucao* nova_instr_estado = getNovaInstrucao();
-        if (nova_instr_estado) {
-            std::string tipoFU_str = verificaUFInstrucao(nova_instr_estado->instrucao);
-            if (tipoFU_str.empty()){
-                std::cerr << "ERROR: Cannot determine FU type for " << nova_instr_estado->instrucao.operacao << std::endl;
-                return;
+    if (amostragem.intervalo > 0) {
+        if (!faixas.empty() || avanco > 0 || !arquivo_checkpoint.empty()) {
+            std::cerr << "Warning: --varredura, --avanca and --restaura are ignored with --amostragem" << std::endl;
+        }
+        std::ios::sync_with_stdio(false);
+        ResultadoAmostragem resultado;
+        if (!executaAmostragem(filename, amostragem, num_threads, cycle_limit, resultado)) return 1;
+        std::ofstream arquivo;
+        if (!arquivo_saida.empty()) {
+            arquivo.open(arquivo_saida);
+            if (!arquivo.is_open()) {
+                std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                return 1;
             }
+        }
+        escreveAmostragem(arquivo_saida.empty() ? std::cout : arquivo, formato, resultado, amostragem);
+        return 0;
+    }
 
-            if (tipoFU_str == "Load" || tipoFU_str == "Store") {
-                UnidadeFuncionalMemoria* uf_para_usar = getFUVaziaMem(tipoFU_str);
-                if (uf_para_usar) {
-                    alocaFuMem(*uf_para_usar, nova_instr_estado->instrucao, *nova_instr_estado);
-                    nova_instr_estado->issue = clock_cycle;
-                    if (uf_para_usar->instrucao_details.has_value() &&
-                        uf_para_usar->instrucao_details.value().operacao != "SD") {
-                        escreveEstacaoRegistrador(nova_instr_estado->instrucao, uf_para_usar->nome);
-                    }
-                }
-            } else {
-                UnidadeFuncional* uf_para_usar = getFUVaziaArithInt(tipoFU_str);
-                if (uf_para_usar) {
-                    alocaFU(*uf_para_usar, nova_instr_estado->instrucao, *nova_instr_estado);
-                    nova_instr_estado->issue = clock_cycle;
-                    const auto& op = nova_instr_estado->instrucao.operacao;
-                    if (op != "BEQ" && op != "BNEZ") {
-                        escreveEstacaoRegistrador(nova_instr_estado->instrucao, uf_para_usar->nome);
-                    }
-                }
+    if (!arquivos_smt.empty()) {
+        if (!faixas.empty() || !arquivo_checkpoint.empty() || estatisticas || !arquivo_eventos.empty() || !arquivo_resultados.empty()) {
+            std::cerr << "Warning: --varredura, --restaura, --estatisticas, --eventos and --resultados are ignored with --smt" << std::endl;
+        }
+        std::ios::sync_with_stdio(false);
+        std::ofstream arquivo;
+        if (!arquivo_saida.empty()) {
+            arquivo.open(arquivo_saida);
+            if (!arquivo.is_open()) {
+                std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                return 1;
             }
         }
+        arquivos_smt.insert(arquivos_smt.begin(), filename);
+        return executaSMT(arquivos_smt, politica, cycle_limit, avanco, formato, arquivo_saida.empty() ? std::cout : arquivo) ? 0 : 1;
     }
 
-    void executaInstrucao() { //verifica se a unidade funcional não tem dependências, decrementa o tempo restante de execução e marca o ciclo de término da instrução
-        for (auto& pair : unidadesFuncionaisMemoria) {
-            UnidadeFuncionalMemoria& uf_mem = pair.second;
-            if (uf_mem.ocupado && !uf_mem.qi.has_value() && !uf_mem.qj.has_value()) {
-                if (uf_mem.tempo.has_value()) {
-                    if (uf_mem.tempo.value() > 0) {
-                        uf_mem.tempo = uf_mem.tempo.value() - 1;
-                        if (uf_mem.estadoInstrucaoOriginal)
-                            uf_mem.estadoInstrucaoOriginal->busy = true;
-                    }
-                    if (uf_mem.tempo.value() == 0) {
-                        if (uf_mem.estadoInstrucaoOriginal) {
-                            uf_mem.estadoInstrucaoOriginal->exeCompleta = clock_cycle;
-                            uf_mem.estadoInstrucaoOriginal->busy = false;
-                            uf_mem.tempo = -1;
-                        }
-                    }
-                }
+    if (!arquivos_nucleos.empty() || num_nucleos > 1) {
+        if (!faixas.empty() || !arquivo_checkpoint.empty() || estatisticas || !arquivo_eventos.empty() || !arquivo_resultados.empty()) {
+            std::cerr << "Warning: --varredura, --restaura, --estatisticas, --eventos and --resultados are ignored with --nucleo/--nucleos" << std::endl;
+        }
+        std::ios::sync_with_stdio(false);
+        std::ofstream arquivo;
+        if (!arquivo_saida.empty()) {
+            arquivo.open(arquivo_saida);
+            if (!arquivo.is_open()) {
+                std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                return 1;
             }
         }
+        arquivos_nucleos.insert(arquivos_nucleos.begin(), filename);
+        return executaMultinucleo(arquivos_nucleos, std::max(num_nucleos, arquivos_nucleos.size()), num_threads, escala, quantum, cycle_limit, avanco, formato,
+                                  arquivo_saida.empty() ? std::cout : arquivo) ? 0 : 1;
+    }
 
-        for (auto& pair : unidadesFuncionais) {
-            UnidadeFuncional& uf = pair.second;
-            if (uf.ocupado && uf.vj.has_value() && uf.vk.has_value() &&
-                !uf.qj.has_value() && !uf.qk.has_value()) {
-                if (uf.tempo.has_value()) {
-                    if (uf.tempo.value() > 0) {
-                        uf.tempo = uf.tempo.value() - 1;
-                        if (uf.estadoInstrucaoOriginal)
-                            uf.estadoInstrucaoOriginal->busy = true;
-                    }
-                    if (uf.tempo.value() == 0) {
-                        if (uf.estadoInstrucaoOriginal) {
-                            uf.estadoInstrucaoOriginal->exeCompleta = clock_cycle;
-                            uf.estadoInstrucaoOriginal->busy = false;
-                            uf.tempo = -1;
-                        }
-                    }
-                }
+    if (!faixas.empty()) {
+        if (!arquivo_checkpoint.empty()) std::cerr << "Warning: --restaura is ignored with --varredura; each configuration starts from its own state" << std::endl;
+        std::ios::sync_with_stdio(false);
+        std::ofstream arquivo;
+        if (!arquivo_saida.empty()) {
+            arquivo.open(arquivo_saida);
+            if (!arquivo.is_open()) {
+                std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                return 1;
             }
         }
+        return executaVarredura(filename, faixas, num_threads, cycle_limit, avanco, lockstep, especializados, formato, arquivo_saida.empty() ? std::cout : arquivo) ? 0 : 1;
     }
 
-    void escreveInstrucao() { //registra o resultado da instrução em seu registrador de destino
-        for (auto& pair : unidadesFuncionaisMemoria) {
-            UnidadeFuncionalMemoria& uf_mem = pair.second;
-            if (uf_mem.ocupado && uf_mem.tempo.has_value() && uf_mem.tempo.value() == -1 &&
-                uf_mem.estadoInstrucaoOriginal && !uf_mem.estadoInstrucaoOriginal->write.has_value() &&
-                uf_mem.estadoInstrucaoOriginal->exeCompleta.has_value() &&
-                uf_mem.estadoInstrucaoOriginal->exeCompleta.value() < clock_cycle) {
-                uf_mem.estadoInstrucaoOriginal->write = clock_cycle;
-                if (uf_mem.instrucao_details.has_value()) {
-                    const auto& instr_d = uf_mem.instrucao_details.value();
-                    if (instr_d.operacao != "SD") {
-                        if (estacaoRegistradores.count(instr_d.registradorR)) {
-                            auto& reg_status = estacaoRegistradores.at(instr_d.registradorR);
-                            if (reg_status.has_value() && reg_status.value() == uf_mem.nome) {
-                                reg_status = "VAL(" + uf_mem.nome + ")";
-                            }
-                        }
-                    }
-                }
-                liberaUFEsperandoResultado(uf_mem.nome);
-                desalocaUFMem(uf_mem);
-            }
-        }
-
-        for (auto& pair : unidadesFuncionais) {
-            UnidadeFuncional& uf = pair.second;
-            if (uf.ocupado && uf.tempo.has_value() && uf.tempo.value() == -1 &&
-                uf.estadoInstrucaoOriginal && !uf.estadoInstrucaoOriginal->write.has_value() &&
-                uf.estadoInstrucaoOriginal->exeCompleta.has_value() &&
-                uf.estadoInstrucaoOriginal->exeCompleta.value() < clock_cycle) {
-                uf.estadoInstrucaoOriginal->write = clock_cycle;
-                if (uf.instrucao_details.has_value()) {
-                    const auto& instr_d = uf.instrucao_details.value();
-                    if (instr_d.operacao != "BEQ" && instr_d.operacao != "BNEZ") {
-                        if (estacaoRegistradores.count(instr_d.registradorR)) {
-                            auto& reg_status = estacaoRegistradores.at(instr_d.registradorR);
-                            if (reg_status.has_value() && reg_status.value() == uf.nome) {
-                                reg_status = "VAL(" + uf.nome + ")";
-                            }
-                        }
-                    }
+    if (!arquivo_incremental.empty()) {
+        if (!quieto || estatisticas || !arquivo_eventos.empty() || !arquivo_resultados.empty() || snapshot_a_cada > 0 || !snapshots_em.empty() ||
+            !arquivo_checkpoint.empty() || avanco > 0) {
+            std::cerr << "Warning: --incremental needs --quieto and no --estatisticas, --eventos, --resultados, --snapshot, --restaura or --avanca; ignoring it"
+                      << std::endl;
+        } else {
+            std::ios::sync_with_stdio(false);
+            std::ofstream arquivo;
+            if (!arquivo_saida.empty()) {
+                arquivo.open(arquivo_saida);
+                if (!arquivo.is_open()) {
+                    std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                    return 1;
                 }
-                liberaUFEsperandoResultado(uf.nome);
-                desalocaUF(uf);
             }
+            return executaIncremental(filename, arquivo_incremental, intervalo_incremental, cycle_limit, lista_instrucoes, formato,
+                                      arquivo_saida.empty() ? std::cout : arquivo) ? 0 : 1;
         }
     }
 
-    bool executa_ciclo() { //exxecuta um ciclo completo
-        clock_cycle++;
-        issueNovaInstrucao();
-        executaInstrucao();
-        escreveInstrucao();
-        return verificaSeJaTerminou();
+    ConfigSimulador config;
+    std::unique_ptr<Estado> estado = carregaSimulador(filename, streaming, config);
+    if (!estado) {
+        return 1;
+    }
+    if (config.tamanhoL1 > 0 && !config.funcional) {
+        std::cerr << "Warning: L1D_SIZE needs FUNCTIONAL 1 for real addresses; using the fixed Load/Store latency" << std::endl;
+    }
+    Estado& simulador = *estado;
+    if (simulador.programaVazio()) { // antes de restaurar ou avançar: depois do fim do trace o estado também não tem o que emitir
+        std::cout << "No instructions found in the input file." << std::endl;
+        return 0;
+    }
+    if (!arquivo_checkpoint.empty()) {
+        if (!restauraCheckpoint(arquivo_checkpoint, simulador)) return 1;
+        if (avanco > 0) std::cerr << "Warning: --avanca is ignored when restoring a checkpoint" << std::endl;
+    } else if (avanco > 0) {
+        executaAvanco(simulador, avanco);
     }
 
-    void printEstadoDebug() const { //imprime o estado das instruções, unidades funcionais, memória e registradores
-        std::cout << "\n--- Clock: " << clock_cycle << " ---" << std::endl;
-        std::cout << "\n== Status das Instrucoes ==" << std::endl;
-        std::cout << std::left << std::setw(5) << "#"
-                  << std::setw(8) << "Instr"
-                  << std::setw(5) << "R"
-                  << std::setw(8) << "S"
-                  << std::setw(8) << "T"
-                  << std::setw(7) << "Issue"
-                  << std::setw(7) << "Exec"
-                  << std::setw(7) << "Write"
-                  << std::setw(6) << "Busy" << std::endl;
-        for (const auto& s : estadoInstrucoes) {
-            std::cout << std::left << std::setw(5) << s.posicao
-                      << std::setw(8) << s.instrucao.operacao
-                      << std::setw(5) << s.instrucao.registradorR
-                      << std::setw(8) << s.instrucao.registradorS
-                      << std::setw(8) << s.instrucao.registradorT
-                      << std::setw(7) << (s.issue.has_value() ? std::to_string(s.issue.value()) : "-")
-                      << std::setw(7) << (s.exeCompleta.has_value() ? std::to_string(s.exeCompleta.value()) : "-")
-                      << std::setw(7) << (s.write.has_value() ? std::to_string(s.write.value()) : "-")
-                      << std::setw(6) << (s.busy ? "Sim" : "Nao") << std::endl;
-        }
-
-        std::cout << "\n== Estacoes de Reserva (Aritmeticas/Inteiro) ==" << std::endl;
-        std::cout << std::left << std::setw(10) << "Nome"
-                  << std::setw(8) << "Ocupado"
-                  << std::setw(7) << "Tempo"
-                  << std::setw(10) << "Op"
-                  << std::setw(12) << "Vj"
-                  << std::setw(12) << "Vk"
-                  << std::setw(10) << "Qj"
-                  << std::setw(10) << "Qk" << std::endl;
-        for (const auto& pair : unidadesFuncionais) {
-            const auto& uf = pair.second;
-            std::cout << std::left << std::setw(10) << uf.nome
-                      << std::setw(8) << (uf.ocupado ? "Sim" : "Nao")
-                      << std::setw(7) << (uf.tempo.has_value() ? std::to_string(uf.tempo.value()) : "-")
-                      << std::setw(10) << (uf.operacao.has_value() ? uf.operacao.value() : "-")
-                      << std::setw(12) << (uf.vj.has_value() ? uf.vj.value() : "-")
-                      << std::setw(12) << (uf.vk.has_value() ? uf.vk.value() : "-")
-                      << std::setw(10) << (uf.qj.has_value() ? uf.qj.value() : "-")
-                      << std::setw(10) << (uf.qk.has_value() ? uf.qk.value() : "-") << std::endl;
-        }
-
-        std::cout << "\n== Buffers de Load/Store (Memoria) ==" << std::endl;
-        std::cout << std::left << std::setw(10) << "Nome"
-                  << std::setw(8) << "Ocupado"
-                  << std::setw(7) << "Tempo"
-                  << std::setw(8) << "Op"
-                  << std::setw(15) << "Endereco"
-                  << std::setw(10) << "Dest/Src"
-                  << std::setw(10) << "Qi"
-                  << std::setw(10) << "Qj (Base)" << std::endl;
-        for (const auto& pair : unidadesFuncionaisMemoria) {
-            const auto& uf = pair.second;
-            std::cout << std::left << std::setw(10) << uf.nome
-                      << std::setw(8) << (uf.ocupado ? "Sim" : "Nao")
-                      << std::setw(7) << (uf.tempo.has_value() ? std::to_string(uf.tempo.value()) : "-")
-                      << std::setw(8) << (uf.operacao.has_value() ? uf.operacao.value() : "-")
-                      << std::setw(15) << (uf.endereco.has_value() ? uf.endereco.value() : "-")
-                      << std::setw(10) << (uf.destino.has_value() ? uf.destino.value() : "-")
-                      << std::setw(10) << (uf.qi.has_value() ? uf.qi.value() : "-")
-                      << std::setw(10) << (uf.qj.has_value() ? uf.qj.value() : "-") << std::endl;
-        }
-
-        std::cout << "\n== Status dos Registradores ==" << std::endl;
-        bool first_reg = true;
-        for (const auto& pair : estacaoRegistradores) {
-            if (!first_reg) std::cout << ", ";
-            std::cout << pair.first << ":" << (pair.second.has_value() ? pair.second.value() : "null");
-            first_reg = false;
+    std::ofstream saida_resultados;
+    std::unique_ptr<GravadorResultados> gravador;
+    if (!arquivo_resultados.empty()) {
+        saida_resultados.open(arquivo_resultados);
+        if (!saida_resultados.is_open()) {
+            std::cerr << "Error: Could not open file " << arquivo_resultados << std::endl;
+            return 1;
         }
-        std::cout << "\n-----------------------------------------" << std::endl;
+        gravador = std::make_unique<GravadorResultados>(saida_resultados);
+        simulador.destinosResultados.push_back(gravador.get());
     }
-};
-
-std::string trim(const std::string& str) {
-    const std::string whitespace = " \t\n\r\f\v";
-    size_t start = str.find_first_not_of(whitespace);
-    if (start == std::string::npos)
-        return "";
-    size_t end = str.find_last_not_of(whitespace);
-    return str.substr(start, end - start + 1);
-}
 
-bool parseInputFile(const std::string& filename, ConfigSimulador& out_config, std::vector<InstrucaoInput>& out_instructions) { //eitura do arquivo de entrada
-    std::ifstream infile(filename);
-    if (!infile.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return false;
+    Contadores contadores;
+    if (estatisticas) simulador.ativaContadores(contadores);
+    std::unique_ptr<RegistroEventos> eventos;
+    if (!arquivo_eventos.empty()) {
+        eventos = std::make_unique<RegistroEventos>(capacidade_eventos);
+        simulador.eventos = eventos.get();
     }
 
-    std::string line;
-    enum class ParseState { NONE, CONFIG, INSTRUCTIONS };
-    ParseState currentState = ParseState::NONE;
-
-    while (std::getline(infile, line)) {
-        line = trim(line);
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-
-        if (line == "CONFIG_BEGIN") {
-            currentState = ParseState::CONFIG;
-            continue;
-        } else if (line == "CONFIG_END") {
-            currentState = ParseState::NONE;
-            continue;
-        } else if (line == "INSTRUCTIONS_BEGIN") {
-            currentState = ParseState::INSTRUCTIONS;
-            continue;
-        } else if (line == "INSTRUCTIONS_END") {
-            currentState = ParseState::NONE;
-            break;
-        }
+    bool terminou = simulador.vazio(); // restaurado ou avançado depois do fim
+    bool travou = false;
 
-        std::stringstream ss(line);
-        std::string keyword, param1, param2_str;
-        int param2_val;
+    if (quieto) { // sem impressão por ciclo: só snapshots pedidos e o relatório final
+        std::ios::sync_with_stdio(false);
+        ColetorResultados coletor;
+        if (lista_instrucoes) simulador.destinosResultados.push_back(&coletor);
 
-        if (currentState == ParseState::CONFIG) {
-            ss >> keyword;
-            if (keyword == "CYCLES") {
-                ss >> param1 >> param2_val;
-                out_config.ciclos[param1] = param2_val;
-            } else if (keyword == "UNITS") {
-                ss >> param1 >> param2_val;
-                out_config.unidades[param1] = param2_val;
-            } else if (keyword == "MEM_UNITS") {
-                ss >> param1 >> param2_val;
-                out_config.unidadesMem[param1] = param2_val;
-            } else {
-                std::cerr << "Warning: Unknown config keyword '" << keyword << "' in line: " << line << std::endl;
+        // só os totais, sem nada que observe o Estado por dentro: uma forma registrada roda no seu núcleo especializado
+        const NucleoRegistrado* nucleo = nullptr;
+        if (especializados && !streaming && !lista_instrucoes && !estatisticas && !eventos && !gravador && snapshot_a_cada == 0 && snapshots_em.empty() &&
+            arquivo_checkpoint.empty() && avanco == 0 && !simulador.config.funcional) {
+            nucleo = buscaNucleoFixo(simulador.config);
+            for (const auto& d : simulador.programa->instrucoes) {
+                if (d.classe == ClasseUF::Nenhuma) nucleo = nullptr;
             }
-        } else if (currentState == ParseState::INSTRUCTIONS) {
-            InstrucaoInput instr;
-            ss >> instr.d_operacao >> instr.r_reg >> instr.s_reg_or_imm >> instr.t_reg_or_label;
-            if (!instr.d_operacao.empty()) {
-                out_instructions.push_back(instr);
-            } else {
-                std::cerr << "Warning: Could not parse instruction line: " << line << std::endl;
+        }
+        ResumoExecucao resumo;
+        if (nucleo) {
+            FontePrograma fonte(simulador.programa);
+            resumo = nucleo->executa(fonte, simulador.programa->nomeRegistrador.size(), cycle_limit);
+        } else {
+            std::string situacao = executaEmLote(simulador, cycle_limit, snapshot_a_cada, snapshots_em);
+            if (lista_instrucoes) simulador.resultadosEmAberto(coletor.resultados);
+            resumo = {situacao, simulador.clock_cycle, simulador.instrucoesConcluidas()};
+        }
+        std::ofstream arquivo;
+        if (!arquivo_saida.empty()) {
+            arquivo.open(arquivo_saida);
+            if (!arquivo.is_open()) {
+                std::cerr << "Error: Could not open file " << arquivo_saida << std::endl;
+                return 1;
             }
         }
-    }
-    out_config.numInstrucoes = out_instructions.size();
-    return true;
-}
-
-int main(int argc, char* argv[]) { //leitura do arquivo principal, criação do simulador, decisão de execução do algoritmo e executa todas as instruções
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file.txt>" << std::endl;
-        return 1;
-    }
-    std::string filename = argv[1];
-
-    ConfigSimulador config;
-    std::vector<InstrucaoInput> instructions;
-
-    if (!parseInputFile(filename, config, instructions)) {
-        return 1;
-    }
-
-    if (instructions.empty()) {
-        std::cout << "No instructions found in the input file." << std::endl;
+        escreveRelatorio(arquivo_saida.empty() ? std::cout : arquivo, formato, resumo, simulador.contadores, coletor.resultados, *simulador.programa);
+        if (simulador.config.funcional && formato == FormatoRelatorio::Texto) simulador.escreveValores(arquivo_saida.empty() ? std::cout : arquivo);
+        if (eventos && !gravaEventos(arquivo_eventos, *eventos, simulador)) return 1;
         return 0;
     }
 
-    Estado simulador(config, instructions);
-    bool terminou = false;
-    int cycle_limit = 200;
-    int current_cycle = 0;
-
     std::cout << "Simulacao Iniciada. Pressione Enter para avancar ciclo a ciclo, ou 'r' para rodar ate o fim." << std::endl;
     simulador.printEstadoDebug();
 
-    char step_mode = 's';
-    if (argc > 2 && std::string(argv[2]) == "run") {
-        step_mode = 'r';
-    }
-
-    while (!terminou && current_cycle < cycle_limit) {
+    while (!terminou && (cycle_limit == 0 || simulador.clock_cycle < cycle_limit)) {
+        int ociosos = simulador.ciclosOciosos();
+        if (ociosos < 0) {
+            travou = true;
+            break;
+        }
+        if (salta_ociosos) {
+            if (cycle_limit > 0) ociosos = static_cast<int>(std::min<long long>(ociosos, cycle_limit - simulador.clock_cycle - 1));
+            simulador.saltaCiclos(ociosos);
+        }
         if (step_mode == 's') {
             std::cout << "Pressione Enter para o proximo ciclo (Clock: " << simulador.clock_cycle + 1 << ") ou 'r' para rodar ate o fim: ";
             char c = std::cin.get();
@@ -694,7 +6245,6 @@ int main(int argc, char* argv[]) { //leitura do arquivo principal, criação do
             }
         }
         terminou = simulador.executa_ciclo();
-        current_cycle = simulador.clock_cycle;
         simulador.printEstadoDebug();
 
         if (terminou) {
@@ -702,18 +6252,24 @@ int main(int argc, char* argv[]) { //leitura do arquivo principal, criação do
         }
     }
 
-    if (!terminou && current_cycle >= cycle_limit) {
+    if (travou) {
+        std::cout << "\n== Simulacao Parada: nenhuma instrucao pode mais avancar (Clock: " << simulador.clock_cycle << "). ==" << std::endl;
+    } else if (!terminou) {
         std::cout << "\n== Simulacao Parada: Limite de ciclos (" << cycle_limit << ") atingido. ==" << std::endl;
     }
 
     std::cout << "\n== Estado Final dos Registradores Usados/Definidos ==" << std::endl;
     bool first_reg = true;
-    for (const auto& pair : simulador.estacaoRegistradores) {
+    for (uint32_t r : simulador.programa->ordemRegistradores) {
+        if (!simulador.registradores.visivel[r]) continue;
         if (!first_reg) std::cout << "; ";
-        std::cout << pair.first << ": " << (pair.second.has_value() ? pair.second.value() : "initial/unused");
+        std::cout << simulador.programa->nomes.nome(simulador.programa->nomeRegistrador[r]) << ": " << simulador.descreveRegistrador(r, "initial/unused");
         first_reg = false;
     }
     std::cout << std::endl;
+    if (simulador.config.funcional) simulador.escreveValores(std::cout);
 
+    if (estatisticas) escreveEstatisticas(std::cout, contadores, *simulador.programa);
+    if (eventos && !gravaEventos(arquivo_eventos, *eventos, simulador)) return 1;
     return 0;
 }